@@ -0,0 +1,108 @@
+#include "arena.h"
+#include <stdlib.h>
+
+#define TAM_PAGINA (64 * 1024)
+#define ALINEACION 8
+#define CANT_CLASES 32
+#define TAM_CLASE_MAX (CANT_CLASES * ALINEACION)
+
+/* Los bloques de hasta TAM_CLASE_MAX bytes salen de páginas de TAM_PAGINA.
+ * Los más grandes se piden aparte con un encabezado que los enlaza, para
+ * poder liberarlos de a uno y también todos juntos al destruir la arena. */
+
+typedef struct pagina{
+    struct pagina* sig;
+    size_t usado;
+    char datos[];
+}pagina_t;
+
+typedef struct bloque_libre{
+    struct bloque_libre* sig;
+}bloque_libre_t;
+
+typedef struct bloque_grande{
+    struct bloque_grande* ant;
+    struct bloque_grande* sig;
+    char datos[];
+}bloque_grande_t;
+
+struct arena{
+    pagina_t* paginas;
+    bloque_libre_t* libres[CANT_CLASES];
+    bloque_grande_t* grandes;
+};
+
+static size_t clase(size_t tam){
+    return (tam + ALINEACION - 1) / ALINEACION - 1;
+}
+
+arena_t *arena_crear(void){
+    return calloc(1, sizeof(arena_t));
+}
+
+static void *pedir_grande(arena_t *arena, size_t tam){
+    bloque_grande_t* bloque = malloc(sizeof(bloque_grande_t) + tam);
+    if(!bloque) return NULL;
+    bloque->ant = NULL;
+    bloque->sig = arena->grandes;
+    if(arena->grandes) arena->grandes->ant = bloque;
+    arena->grandes = bloque;
+    return bloque->datos;
+}
+
+void *arena_pedir(arena_t *arena, size_t tam){
+    if(tam == 0) tam = 1;
+    if(tam > TAM_CLASE_MAX) return pedir_grande(arena, tam);
+
+    size_t c = clase(tam);
+    if(arena->libres[c]){
+        bloque_libre_t* bloque = arena->libres[c];
+        arena->libres[c] = bloque->sig;
+        return bloque;
+    }
+
+    size_t tam_bloque = (c + 1) * ALINEACION;
+    pagina_t* pagina = arena->paginas;
+    if(!pagina || pagina->usado + tam_bloque > TAM_PAGINA){
+        pagina = malloc(sizeof(pagina_t) + TAM_PAGINA);
+        if(!pagina) return NULL;
+        pagina->usado = 0;
+        pagina->sig = arena->paginas;
+        arena->paginas = pagina;
+    }
+    void* bloque = pagina->datos + pagina->usado;
+    pagina->usado += tam_bloque;
+    return bloque;
+}
+
+void arena_liberar(arena_t *arena, void *bloque, size_t tam){
+    if(!bloque) return;
+    if(tam == 0) tam = 1;
+    if(tam > TAM_CLASE_MAX){
+        bloque_grande_t* grande = (bloque_grande_t*) ((char*) bloque - offsetof(bloque_grande_t, datos));
+        if(grande->ant) grande->ant->sig = grande->sig;
+        else arena->grandes = grande->sig;
+        if(grande->sig) grande->sig->ant = grande->ant;
+        free(grande);
+        return;
+    }
+
+    size_t c = clase(tam);
+    bloque_libre_t* libre = bloque;
+    libre->sig = arena->libres[c];
+    arena->libres[c] = libre;
+}
+
+void arena_destruir(arena_t *arena){
+    while(arena->paginas){
+        pagina_t* sig = arena->paginas->sig;
+        free(arena->paginas);
+        arena->paginas = sig;
+    }
+    while(arena->grandes){
+        bloque_grande_t* sig = arena->grandes->sig;
+        free(arena->grandes);
+        arena->grandes = sig;
+    }
+    free(arena);
+}
@@ -0,0 +1,30 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/* Arena de memoria para bloques chicos: reparte páginas grandes avanzando
+ * un puntero y recicla los bloques liberados con una lista por clase de
+ * tamaño. Destruirla libera todas las páginas de una vez, sin recorrer los
+ * bloques. */
+struct arena;
+typedef struct arena arena_t;
+
+// Crea una arena vacía. Devuelve NULL si no hay memoria.
+arena_t *arena_crear(void);
+
+/* Devuelve un bloque de al menos tam bytes, alineado a 8, o NULL si no hay
+ * memoria.
+ * Pre: la arena fue creada
+ */
+void *arena_pedir(arena_t *arena, size_t tam);
+
+/* Devuelve el bloque a la arena para que se reutilice.
+ * Pre: bloque fue devuelto por arena_pedir con el mismo tam
+ */
+void arena_liberar(arena_t *arena, void *bloque, size_t tam);
+
+// Libera todas las páginas de la arena y la arena misma.
+void arena_destruir(arena_t *arena);
+
+#endif // ARENA_H
@@ -0,0 +1,67 @@
+#define _POSIX_C_SOURCE 200809L
+#include "escritor.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define LARGO_BUFFER (64 * 1024)
+
+struct escritor{
+    int fd;
+    size_t usado;
+    bool ok;
+    char buffer[LARGO_BUFFER];
+};
+
+static const char ceros[sizeof(uint64_t)];
+
+bool escribir_todo(int fd, const void *bytes, size_t largo){
+    const char* actual = bytes;
+    while (largo > 0){
+        ssize_t escritos = write(fd, actual, largo);
+        if (escritos < 0 && errno == EINTR) continue;
+        if (escritos <= 0) return false;
+        actual += escritos;
+        largo -= (size_t) escritos;
+    }
+    return true;
+}
+
+escritor_t *escritor_crear(int fd){
+    escritor_t* escritor = malloc(sizeof(escritor_t));
+    if (!escritor) return NULL;
+    escritor->fd = fd;
+    escritor->usado = 0;
+    escritor->ok = true;
+    return escritor;
+}
+
+static void vaciar(escritor_t *escritor){
+    if (escritor->ok) escritor->ok = escribir_todo(escritor->fd, escritor->buffer, escritor->usado);
+    escritor->usado = 0;
+}
+
+void escritor_escribir(escritor_t *escritor, const void *bytes, size_t largo){
+    if (!largo) return;
+    if (largo >= LARGO_BUFFER){
+        vaciar(escritor);
+        if (escritor->ok) escritor->ok = escribir_todo(escritor->fd, bytes, largo);
+        return;
+    }
+    if (escritor->usado + largo > LARGO_BUFFER) vaciar(escritor);
+    memcpy(escritor->buffer + escritor->usado, bytes, largo);
+    escritor->usado += largo;
+}
+
+void escritor_escribir_alineado(escritor_t *escritor, const void *bytes, size_t largo){
+    escritor_escribir(escritor, bytes, largo);
+    escritor_escribir(escritor, ceros, alinear(largo) - largo);
+}
+
+bool escritor_destruir(escritor_t *escritor){
+    vaciar(escritor);
+    bool ok = escritor->ok;
+    free(escritor);
+    return ok;
+}
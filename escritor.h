@@ -0,0 +1,38 @@
+#ifndef ESCRITOR_H
+#define ESCRITOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Escritor con buffer para armar imágenes en un archivo: junta lo que se
+ * escribe y lo pasa al archivo de a bloques. Después del primer error no
+ * escribe más, y escritor_destruir lo informa. Lo usan los snapshots del
+ * hash y los hashes congelados guardados. */
+struct escritor;
+typedef struct escritor escritor_t;
+
+// Las imágenes ponen cada sección en un múltiplo de 8 bytes, para que se
+// pueda leer en su lugar.
+static inline size_t alinear(size_t desplazamiento){
+    return (desplazamiento + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
+}
+
+// Escribe los largo bytes en el archivo, reintentando las escrituras
+// parciales o interrumpidas. Devuelve false si alguna falló.
+bool escribir_todo(int fd, const void *bytes, size_t largo);
+
+// Crea un escritor sobre el archivo fd. Devuelve NULL si no hay memoria.
+escritor_t *escritor_crear(int fd);
+
+// Escribe los bytes. Los bloques más grandes que el buffer van directo.
+void escritor_escribir(escritor_t *escritor, const void *bytes, size_t largo);
+
+// Escribe los bytes y después ceros hasta el siguiente múltiplo de 8.
+void escritor_escribir_alineado(escritor_t *escritor, const void *bytes, size_t largo);
+
+// Pasa al archivo lo que quedó en el buffer y libera el escritor. Devuelve
+// true si se escribió todo.
+bool escritor_destruir(escritor_t *escritor);
+
+#endif // ESCRITOR_H
@@ -1,16 +1,31 @@
+#define _POSIX_C_SOURCE 200809L
 #include "hash.h"
+#include "arena.h"
+#include "escritor.h"
+#include "pool.h"
+#include <fcntl.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <memory.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-#define CAPACIDAD_INICIAL 11
-#define BITE_ESTADO 1
+#define CAPACIDAD_INICIAL 16
 #define POS_INICIAL 0
-<<<<<<< HEAD
-#define BORRADOS_INICIAL 0
 #define VALOR_AGRANDAR 0.7
-#define VALOR_REDUCIR 0.3
-#define CANT_CAMPOS 3
+#define VALOR_REDUCIR 0.25
+#define FACTOR_CRECIMIENTO 2
+#define FACTOR_CRECIMIENTO_MAX 64
+#define HISTERESIS 0.1
+#define CARGA_MAXIMA_TOPE 0.95
+
+// Las claves de hasta este largo se guardan dentro del campo, sin pedir memoria
+#ifndef HASH_LARGO_CLAVE_INLINE
+#define HASH_LARGO_CLAVE_INLINE 15
+#endif
+
 /* ******************************************************************
  *                        STRUCT HASH
  * *****************************************************************/
@@ -18,658 +33,2020 @@ typedef enum {
 	REDUCIR = 1,
 	AGRANDAR = 0,
 }criterio_t;
-=======
-#define TAM_MIN 11
-
->>>>>>> 81a106131497f70590d10ae654a716fa9404a3b7
 
 typedef enum {
 	VACIO,
 	OCUPADO,
-	BORRADO,
 }tipo_estado;
-<<<<<<< HEAD
-=======
-
-typedef enum {
-	ACHICAR=1,
-	AGRANDAR,
-}criterio_t;
-
->>>>>>> 81a106131497f70590d10ae654a716fa9404a3b7
 
+/* Los campos se guardan en línea dentro de la tabla: crear o redimensionar
+ * la tabla es una sola reserva de memoria y sondear no sigue punteros.
+ * calloc deja cada campo en estado VACIO. El hash completo de la clave queda
+ * guardado para descartar campos sin leer la clave y para redimensionar sin
+ * volver a hashear.
+ *
+ * La tabla usa sondeo lineal Robin Hood: al insertar, un campo que está más
+ * lejos de su posición inicial le quita el lugar a uno que está más cerca, y
+ * al borrar se corren hacia atrás los campos siguientes. Así no hacen falta
+ * campos BORRADO y las cadenas de sondeo se mantienen cortas.
+ *
+ * Las claves cortas se copian dentro del mismo campo; las más largas que
+ * HASH_LARGO_CLAVE_INLINE van aparte. En los dos casos terminan en '\0' y el
+ * largo queda guardado para comparar con memcmp. */
 typedef struct campo{
+    uint64_t hash;
     void* dato;
-    int estado;
-    char* clave;
+    uint32_t largo;
+    uint32_t estado;
+    union {
+        char* externa;
+        char interna[HASH_LARGO_CLAVE_INLINE + 1];
+    } clave;
 }campo_t;
 
 
+/* Arreglo de campos con sus bytes de control. Durante una redimensión
+ * incremental el hash tiene dos tablas a la vez.
+ * ocupados tiene un bit por campo, en 1 si está OCUPADO: recorrer la tabla
+ * salta de a 64 campos vacíos leyendo una sola palabra. */
+typedef struct tabla{
+    campo_t* campos;
+    uint32_t* indices; // sólo con compacto, en lugar de campos
+    uint64_t* ocupados;
+    uint8_t* control; // sólo con HASH_MOTOR_GRUPOS
+    size_t capacidad; // siempre potencia de dos, o 0 si no hay tabla
+    size_t mascara;
+}tabla_t;
+
+/* Imagen de un snapshot: el encabezado, las capacidad ranuras en las mismas
+ * posiciones que tenían los campos en la tabla y un bloque con las claves,
+ * terminadas en '\0', y los datos. Todo se refiere con desplazamientos desde
+ * el comienzo de la imagen; el desplazamiento 0 nunca es una clave, así que
+ * marca las ranuras vacías. */
+typedef struct snapshot{
+    char magia[8];
+    uint64_t capacidad;
+    uint64_t cantidad;
+    uint64_t semilla;
+    uint64_t control; // hash de la magia, para detectar otra función de hash
+    uint64_t largo;   // bytes de la imagen completa
+    uint64_t reservado[2];
+}snapshot_t;
+
+typedef struct ranura{
+    uint64_t hash;
+    uint64_t clave;
+    uint64_t dato;
+    uint32_t largo;
+    uint32_t largo_dato;
+}ranura_t;
+
 struct hash{
-<<<<<<< HEAD
     void (*destruir_dato)(void*);
-=======
-    void (*destruir_dato) (void*);
->>>>>>> 81a106131497f70590d10ae654a716fa9404a3b7
-    campo_t** tabla;
-    size_t capacidad;
+    hash_funcion_t funcion_hash;
+    uint64_t semilla;
+    arena_t* arena; // sólo con arena_claves
+    hash_politica_t politica;
+    tabla_t tabla;
+    tabla_t vieja; // tabla que se está migrando, sólo con redimension_incremental
+    size_t inicio_migracion;
+    size_t migrados;
+    bool incremental;
+    bool con_control;
+    pool_t* pool; // sólo con pool, no es del hash
+    size_t ancho_grupo;
+    const snapshot_t* snapshot; // sólo con hash_abrir_snapshot, sin tablas
+    bool compacto;
+    campo_t* entradas; // sólo con compacto, en orden de inserción
+    size_t usadas;     // entradas escritas, contando las borradas
+    size_t capacidad_entradas;
+    size_t pendientes; // borrados con hash_iter_borrar_actual sin compactar
+    size_t modificaciones;
     size_t cantidad;
-    size_t borrados;
 };
 
 
 struct hash_iter{
-<<<<<<< HEAD
-    size_t cant;
-=======
->>>>>>> 81a106131497f70590d10ae654a716fa9404a3b7
     size_t pos;
     const hash_t* hash;
+    size_t fin;            // posición donde termina el rango
+    size_t modificaciones; // las del hash al crearlo
+    bool borro;            // borró con hash_iter_borrar_actual
 };
 
 /* ******************************************************************
  *                        FUNCION HASH
  * *****************************************************************/
 
-// Función Hash djb2
-int fhash(const char *str){ 
-    int hash = 5381;
-    int c;
-    while ((c = *str++))
-        hash = ((hash << 5) + hash) + c; /* hash * 33 + c */
+/* Función de hash de la familia wyhash: lee la clave de a 8 bytes y mezcla
+ * con multiplicaciones de 64x64->128 bits. Los bits bajos salen bien
+ * distribuidos, así que alcanza con una máscara para obtener la posición. */
+
+#define HASH_P0 UINT64_C(0xa0761d6478bd642f)
+#define HASH_P1 UINT64_C(0xe7037ed1a0b428db)
+#define HASH_P2 UINT64_C(0x8ebc6af09c88c6e3)
+#define HASH_P3 UINT64_C(0x589965cc75374cc3)
+
+static inline void multiplicar_128(uint64_t *a, uint64_t *b){
+#ifdef __SIZEOF_INT128__
+    __extension__ typedef unsigned __int128 uint128_t;
+    uint128_t r = (uint128_t) *a * *b;
+    *a = (uint64_t) r;
+    *b = (uint64_t) (r >> 64);
+#else
+    uint64_t ha = *a >> 32, la = (uint32_t) *a;
+    uint64_t hb = *b >> 32, lb = (uint32_t) *b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
 
-    return hash;
+static inline uint64_t mezclar(uint64_t a, uint64_t b){
+    multiplicar_128(&a, &b);
+    return a ^ b;
+}
+
+static inline uint64_t leer_8(const uint8_t *p){
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t leer_4(const uint8_t *p){
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint64_t hash_funcion_rapida(const void *clave, size_t largo, uint64_t semilla){
+    const uint8_t *p = clave;
+    uint64_t a, b;
+    semilla ^= mezclar(semilla ^ HASH_P0, HASH_P1);
+
+    if (largo <= 16){
+        if (largo >= 4){
+            size_t salto = (largo >> 3) << 2;
+            a = (leer_4(p) << 32) | leer_4(p + salto);
+            b = (leer_4(p + largo - 4) << 32) | leer_4(p + largo - 4 - salto);
+        } else if (largo > 0){
+            a = ((uint64_t) p[0] << 16) | ((uint64_t) p[largo >> 1] << 8) | p[largo - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = largo;
+        if (i > 48){
+            uint64_t s1 = semilla, s2 = semilla;
+            do {
+                semilla = mezclar(leer_8(p) ^ HASH_P1, leer_8(p + 8) ^ semilla);
+                s1 = mezclar(leer_8(p + 16) ^ HASH_P2, leer_8(p + 24) ^ s1);
+                s2 = mezclar(leer_8(p + 32) ^ HASH_P3, leer_8(p + 40) ^ s2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            semilla ^= s1 ^ s2;
+        }
+        while (i > 16){
+            semilla = mezclar(leer_8(p) ^ HASH_P1, leer_8(p + 8) ^ semilla);
+            i -= 16;
+            p += 16;
+        }
+        a = leer_8(p + i - 16);
+        b = leer_8(p + i - 8);
+    }
+    a ^= HASH_P1;
+    b ^= semilla;
+    multiplicar_128(&a, &b);
+    return mezclar(a ^ HASH_P0 ^ largo, b ^ HASH_P1);
 }
 
-<<<<<<< HEAD
 /* ******************************************************************
- *                        PRIMITIVAS HASH
+ *                        MOTOR DE GRUPOS
  * *****************************************************************/
 
-hash_t *hash_crear(hash_destruir_dato_t destruir_dato){
-	
-    hash_t* hash=calloc(1,sizeof(hash_t));
-    if(!hash) return NULL;
-    
-    hash->tabla=calloc(CAPACIDAD_INICIAL,sizeof(campo_t));
-    if(!hash->tabla){
-        free(hash);
-        return NULL;
+/* Con HASH_MOTOR_GRUPOS la tabla lleva al lado un byte de control por campo:
+ * CONTROL_VACIO o los 7 bits altos del hash. Las búsquedas comparan un grupo
+ * de 16 (SSE2) o 32 (AVX2) bytes de control por instrucción y sólo leen los
+ * campos cuya etiqueta coincide. Los primeros GRUPO_MAX - 1 bytes se repiten
+ * al final del arreglo para poder leer un grupo que da la vuelta a la tabla. */
+
+#define GRUPO_MAX 32
+#define CONTROL_VACIO 0x80
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define HASH_X86 1
+#include <immintrin.h>
+#endif
+
+static inline uint8_t etiqueta(uint64_t h){
+    return (uint8_t) (h >> 57);
+}
+
+// Escribe el byte de control de pos y sus copias al final del arreglo.
+static void marcar_control(tabla_t *t, size_t pos, uint8_t valor){
+    if (!t->control) return;
+    for (size_t i = pos; i < t->capacidad + GRUPO_MAX - 1; i += t->capacidad){
+        t->control[i] = valor;
     }
+}
 
-    //Recorro la tabla y creo los campos inicialmente en estado VACIO
-    for (size_t i = 0; i < CAPACIDAD_INICIAL; i++){
-        campo_t* campo = malloc(sizeof(campo_t));
-        if(!campo){
-            free(hash->tabla);
-            free(hash);
-            return NULL;
-        } 
-        campo->estado = VACIO;
-        campo->clave = NULL;
-        campo->dato = NULL;
-        hash->tabla[i] = campo;
+static inline const char *clave_de(const campo_t *campo){
+    return campo->largo <= HASH_LARGO_CLAVE_INLINE ? campo->clave.interna : campo->clave.externa;
+}
+
+// Compara primero el hash y el largo, y sólo si coinciden lee la clave.
+static inline bool coincide(const campo_t *campo, const char *clave, size_t largo, uint64_t h){
+    return campo->hash == h && campo->largo == largo && memcmp(clave_de(campo), clave, largo) == 0;
+}
+
+// Busca la clave entre los candidatos, la máscara de los bytes de control
+// del grupo que empieza en pos que coinciden con la etiqueta.
+static inline bool revisar_candidatos(const tabla_t *t, const char *clave, size_t largo, uint64_t h,
+                                      size_t pos, uint32_t candidatos, size_t *encontrado){
+    while (candidatos){
+        size_t i = (pos + (size_t) __builtin_ctz(candidatos)) & t->mascara;
+        if (coincide(&t->campos[i], clave, largo, h)){
+            *encontrado = i;
+            return true;
+        }
+        candidatos &= candidatos - 1;
     }
+    return false;
+}
 
-    hash->destruir_dato = destruir_dato;
-    hash->capacidad = CAPACIDAD_INICIAL; 
-    hash->borrados = BORRADOS_INICIAL;
-    return hash;
+// Devuelve la máscara de los bits anteriores al primer bit de vacios.
+static inline uint32_t antes_del_primero(uint32_t vacios){
+    return vacios ? (vacios & (~vacios + 1)) - 1 : UINT32_MAX;
 }
 
-void *hash_obtener(const hash_t *hash, const char *clave){
-    if(hash->cantidad == 0) return NULL;
-    
-    size_t pos = (size_t) fhash(clave) % hash->capacidad;
-    while(hash->tabla[pos]->estado != VACIO){
-        if (hash->tabla[pos]->estado == OCUPADO && strcmp(hash->tabla[pos]->clave, clave) == 0){
-            return hash->tabla[pos]->dato;
+#ifdef HASH_X86
+static size_t buscar_grupos_sse2(const tabla_t *t, const char *clave, size_t largo, uint64_t h){
+    const __m128i buscada = _mm_set1_epi8((char) etiqueta(h));
+    const __m128i vacio = _mm_set1_epi8((char) CONTROL_VACIO);
+    size_t pos = (size_t) h & t->mascara;
+    size_t encontrado;
+    while (true){
+        __m128i grupo = _mm_loadu_si128((const __m128i *) &t->control[pos]);
+        uint32_t vacios = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(grupo, vacio));
+        uint32_t candidatos = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(grupo, buscada));
+        candidatos &= antes_del_primero(vacios);
+        if (revisar_candidatos(t, clave, largo, h, pos, candidatos, &encontrado)) return encontrado;
+        if (vacios) return t->capacidad;
+        pos = (pos + 16) & t->mascara;
+    }
+}
+
+__attribute__((target("avx2")))
+static size_t buscar_grupos_avx2(const tabla_t *t, const char *clave, size_t largo, uint64_t h){
+    const __m256i buscada = _mm256_set1_epi8((char) etiqueta(h));
+    const __m256i vacio = _mm256_set1_epi8((char) CONTROL_VACIO);
+    size_t pos = (size_t) h & t->mascara;
+    size_t encontrado;
+    while (true){
+        __m256i grupo = _mm256_loadu_si256((const __m256i *) &t->control[pos]);
+        uint32_t vacios = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(grupo, vacio));
+        uint32_t candidatos = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(grupo, buscada));
+        candidatos &= antes_del_primero(vacios);
+        if (revisar_candidatos(t, clave, largo, h, pos, candidatos, &encontrado)) return encontrado;
+        if (vacios) return t->capacidad;
+        pos = (pos + 32) & t->mascara;
+    }
+}
+#endif
+
+// Versión portable: recorre los bytes de control de a uno.
+static size_t buscar_grupos_portable(const tabla_t *t, const char *clave, size_t largo, uint64_t h){
+    uint8_t buscada = etiqueta(h);
+    size_t pos = (size_t) h & t->mascara;
+    while (t->control[pos] != CONTROL_VACIO){
+        if (t->control[pos] == buscada && coincide(&t->campos[pos], clave, largo, h)){
+            return pos;
         }
-        pos = (pos + 1) % hash->capacidad;
+        pos = (pos + 1) & t->mascara;
     }
-=======
-// Función destruir dato
-void destruir_dato(void* dato){
-	free(dato);
-}	
+    return t->capacidad;
+}
 
-  
+// Elige la mejor búsqueda por grupos que soporta el procesador.
+static size_t elegir_ancho_grupo(void){
+#ifdef HASH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return 32;
+    return 16;
+#else
+    return 1;
+#endif
+}
 
-//--------------------------BUSQUEDA---------------------------------
+static size_t buscar_grupos(const hash_t *hash, const tabla_t *t, const char *clave, size_t largo, uint64_t h){
+#ifdef HASH_X86
+    if (hash->ancho_grupo == 32) return buscar_grupos_avx2(t, clave, largo, h);
+    if (hash->ancho_grupo == 16) return buscar_grupos_sse2(t, clave, largo, h);
+#endif
+    return buscar_grupos_portable(t, clave, largo, h);
+}
 
-size_t buscar_vacio(const hash_t *hash, const char *clave){
-	
-	size_t inicial=(size_t)fhash(clave);
-	
-	size_t pos;
-	for (size_t i=0; i< hash->capacidad; i++){
-		pos= (inicial + i)% hash->capacidad;
-		if (!hash->tabla[pos]) return pos;
-	}
-	return 0;
+/* ******************************************************************
+ *                        FUNCIONES AUXILIARES
+ * *****************************************************************/
+
+static uint64_t calcular_hash(const hash_t *hash, const char *clave, size_t largo){
+    return hash->funcion_hash(clave, largo, hash->semilla);
 }
 
+// Copia la clave al campo: dentro del campo si es corta, o en memoria
+// pedida a la arena o a malloc si no.
+static bool copiar_clave(hash_t *hash, campo_t *campo, const char *clave, size_t largo){
+    if (largo > UINT32_MAX) return false;
+    char* destino = campo->clave.interna;
+    if (largo > HASH_LARGO_CLAVE_INLINE){
+        destino = hash->arena ? arena_pedir(hash->arena, largo + 1) : malloc(largo + 1);
+        if(!destino) return false;
+        campo->clave.externa = destino;
+    }
+    memcpy(destino, clave, largo);
+    destino[largo] = '\0';
+    campo->largo = (uint32_t) largo;
+    return true;
+}
 
-size_t buscar_ocupado(const hash_t *hash, const char *clave){
-	
-	size_t inicial=(size_t)fhash(clave);
-	size_t pos;
-	for (size_t i=0; i< hash->capacidad; i++){
-		pos= (inicial + i)% hash->capacidad;
-		if (!hash->tabla[pos]) continue;
-		
-		if (hash->tabla[pos]->estado==OCUPADO && strcmp(hash->tabla[pos]->clave,clave)==0){
-			return pos;
-		} else if (hash->tabla[pos]->estado==VACIO){
-			return 0;
-		}	
-	}
-	return 0;
+static void liberar_clave(hash_t *hash, campo_t *campo){
+    if (campo->largo <= HASH_LARGO_CLAVE_INLINE) return;
+    if(hash->arena) arena_liberar(hash->arena, campo->clave.externa, campo->largo + 1);
+    else free(campo->clave.externa);
 }
 
+// Distancia entre la posición pos y la posición inicial del hash h.
+static inline size_t distancia(const tabla_t *t, uint64_t h, size_t pos){
+    return (pos - ((size_t) h & t->mascara)) & t->mascara;
+}
 
-//------------------------HASH CERRADO---------------------------------
+// Devuelve la posición de la clave en la tabla, o su capacidad si no está.
+static size_t buscar_en_tabla(const hash_t *hash, const tabla_t *t, const char *clave, size_t largo, uint64_t h){
 
+    if (t->control) return buscar_grupos(hash, t, clave, largo, h);
 
-hash_t *hash_crear(hash_destruir_dato_t destruir_dato){
-	
-  hash_t* hash=calloc(1,sizeof(hash_t));
-  if(!hash) return NULL;
-  
-  
-  
-  hash->tabla=calloc(CAPACIDAD_INICIAL,sizeof(campo_t*));
-  if(!hash->tabla){
-    free(hash);
->>>>>>> 81a106131497f70590d10ae654a716fa9404a3b7
+    size_t pos = (size_t) h & t->mascara;
+    for (size_t d = 0; t->campos[pos].estado == OCUPADO; d++){
+        const campo_t* campo = &t->campos[pos];
+        // Por el invariante Robin Hood, la clave no puede estar más adelante
+        if (distancia(t, campo->hash, pos) < d) break;
+        if (coincide(campo, clave, largo, h)){
+            return pos;
+        }
+        pos = (pos + 1) & t->mascara;
+    }
+    return t->capacidad;
+}
+
+/* ******************************************************************
+ *                        DISEÑO COMPACTO
+ * *****************************************************************/
+
+/* Con compacto, los campos van en hash->entradas en orden de inserción y la
+ * tabla sólo tiene indices: 0 si la posición está vacía, o 1 más la entrada
+ * que le corresponde. Los índices siguen el mismo sondeo Robin Hood que los
+ * campos, leyendo el hash guardado en la entrada. Borrar deja la entrada
+ * VACIO hasta que reindexar junta las vivas al principio. */
+
+#define INDICE_VACIO 0
+
+static inline const campo_t* entrada_en(const hash_t *hash, const tabla_t *t, size_t pos){
+    return &hash->entradas[t->indices[pos] - 1];
+}
+
+// Reserva la tabla de índices vacía de la capacidad dada.
+static bool crear_indices(tabla_t *t, size_t capacidad){
+    uint32_t* indices = calloc(capacidad, sizeof(uint32_t));
+    if (!indices) return false;
+
+    t->indices = indices;
+    t->capacidad = capacidad;
+    t->mascara = capacidad - 1;
+    return true;
+}
+
+// Inserta el índice de una entrada, cuya clave no está en la tabla, a partir
+// de la posición pos a distancia d de su posición inicial.
+static void insertar_indice_desde(const hash_t *hash, tabla_t *t, uint32_t indice, size_t pos, size_t d){
+
+    for (; t->indices[pos] != INDICE_VACIO; d++){
+        size_t d_actual = distancia(t, entrada_en(hash, t, pos)->hash, pos);
+        if (d_actual < d){
+            uint32_t desplazado = t->indices[pos];
+            t->indices[pos] = indice;
+            indice = desplazado;
+            d = d_actual;
+        }
+        pos = (pos + 1) & t->mascara;
+    }
+    t->indices[pos] = indice;
+}
+
+// Como sondear, pero sobre los índices.
+static size_t sondear_indices(const hash_t *hash, const tabla_t *t, const char *clave, size_t largo, uint64_t h, size_t *hueco, size_t *dist){
+
+    size_t pos = (size_t) h & t->mascara;
+    size_t d = 0;
+    for (; t->indices[pos] != INDICE_VACIO; d++){
+        const campo_t* entrada = entrada_en(hash, t, pos);
+        if (distancia(t, entrada->hash, pos) < d) break;
+        if (coincide(entrada, clave, largo, h)) return pos;
+        pos = (pos + 1) & t->mascara;
+    }
+    *hueco = pos;
+    *dist = d;
+    return t->capacidad;
+}
+
+// Vacía la posición pos corriendo hacia atrás los índices que le siguen.
+static void quitar_indice(const hash_t *hash, tabla_t *t, size_t pos){
+
+    size_t sig = (pos + 1) & t->mascara;
+    while (t->indices[sig] != INDICE_VACIO && distancia(t, entrada_en(hash, t, sig)->hash, sig) > 0){
+        t->indices[pos] = t->indices[sig];
+        pos = sig;
+        sig = (sig + 1) & t->mascara;
+    }
+    t->indices[pos] = INDICE_VACIO;
+}
+
+// Junta las entradas vivas al principio, en el mismo orden, y arma de nuevo
+// una tabla de índices de la capacidad dada. Sin memoria no cambia nada.
+static bool reindexar(hash_t *hash, size_t capacidad){
+
+    tabla_t nueva = {0};
+    if (!crear_indices(&nueva, capacidad)) return false;
+    hash->modificaciones++;
+
+    size_t vivas = 0;
+    for (size_t i = 0; i < hash->usadas; i++){
+        if (hash->entradas[i].estado == OCUPADO) hash->entradas[vivas++] = hash->entradas[i];
+    }
+    hash->usadas = vivas;
+    free(hash->tabla.indices);
+    hash->tabla = nueva;
+    for (size_t i = 0; i < vivas; i++){
+        size_t pos = (size_t) hash->entradas[i].hash & nueva.mascara;
+        insertar_indice_desde(hash, &hash->tabla, (uint32_t) (i + 1), pos, 0);
+    }
+    return true;
+}
+
+// Agranda el arreglo de entradas para que entren cantidad sin pedir más.
+static bool reservar_entradas(hash_t *hash, size_t cantidad){
+    if (cantidad <= hash->capacidad_entradas) return true;
+    if (cantidad > UINT32_MAX) return false;
+
+    campo_t* entradas = realloc(hash->entradas, cantidad * sizeof(campo_t));
+    if (!entradas) return false;
+    hash->entradas = entradas;
+    hash->capacidad_entradas = cantidad;
+    return true;
+}
+
+// Deja lugar para agregar una entrada al final: si al menos un cuarto de
+// las usadas están borradas alcanza con juntar las vivas; si no, duplica el
+// arreglo.
+static bool lugar_para_entrada(hash_t *hash){
+    if (hash->usadas < hash->capacidad_entradas) return true;
+    if (hash->usadas - hash->cantidad >= hash->usadas / 4 && hash->usadas > hash->cantidad){
+        return reindexar(hash, hash->tabla.capacidad);
+    }
+    size_t capacidad = hash->capacidad_entradas ? hash->capacidad_entradas * 2 : CAPACIDAD_INICIAL;
+    if (capacidad > UINT32_MAX) capacidad = UINT32_MAX;
+    if (capacidad <= hash->usadas) return false;
+    return reservar_entradas(hash, capacidad);
+}
+
+// Como ubicar, agregando la entrada nueva al final del arreglo.
+// Pre: hay lugar para una entrada y un índice más
+static campo_t* ubicar_compacto(hash_t *hash, const char *clave, size_t largo, uint64_t h, bool *insertado){
+
+    *insertado = false;
+    tabla_t* t = &hash->tabla;
+    size_t hueco = 0, dist = 0;
+    size_t pos = sondear_indices(hash, t, clave, largo, h, &hueco, &dist);
+    if (pos != t->capacidad) return &hash->entradas[t->indices[pos] - 1];
+
+    campo_t* entrada = &hash->entradas[hash->usadas];
+    *entrada = (campo_t) {
+        .hash = h,
+        .estado = OCUPADO,
+    };
+    if(!copiar_clave(hash, entrada, clave, largo)) return NULL;
+
+    hash->usadas++;
+    insertar_indice_desde(hash, t, (uint32_t) hash->usadas, hueco, dist);
+    hash->cantidad++;
+    hash->modificaciones++;
+    *insertado = true;
+    return entrada;
+}
+
+// Borra la entrada cuyo índice está en la posición pos de la tabla. La
+// entrada queda VACIO en el arreglo, sin mover a las demás.
+static void quitar_entrada(hash_t *hash, campo_t *entrada, size_t pos){
+    liberar_clave(hash, entrada);
+    quitar_indice(hash, &hash->tabla, pos);
+    entrada->estado = VACIO;
+}
+
+// Busca la clave y devuelve su entrada, dejando en pos su posición en la
+// tabla, o NULL si no está.
+static campo_t* buscar_entrada(const hash_t *hash, const char *clave, size_t largo, uint64_t h, size_t *pos){
+    size_t hueco = 0, dist = 0;
+    size_t p = sondear_indices(hash, &hash->tabla, clave, largo, h, &hueco, &dist);
+    if (p == hash->tabla.capacidad) return NULL;
+    if (pos) *pos = p;
+    return &hash->entradas[hash->tabla.indices[p] - 1];
+}
+
+static void destruir_entradas(hash_t *hash){
+    for (size_t i = 0; i < hash->usadas; i++){
+        if (hash->entradas[i].estado != OCUPADO) continue;
+        if(hash->destruir_dato) hash->destruir_dato(hash->entradas[i].dato);
+        if(!hash->arena) liberar_clave(hash, &hash->entradas[i]);
+    }
+    free(hash->entradas);
+}
+
+#define BITS_POR_PALABRA 64
+
+static inline bool bit_ocupado(const tabla_t *t, size_t pos){
+    return t->ocupados[pos / BITS_POR_PALABRA] >> (pos % BITS_POR_PALABRA) & 1;
+}
+
+// Devuelve el campo de la clave, buscando también en la tabla vieja si hay
+// una migración en curso, o NULL si no está. Si tabla no es NULL, guarda ahí
+// la tabla donde se encontró.
+static campo_t* buscar_campo(const hash_t *hash, const char *clave, size_t largo, uint64_t h, tabla_t **tabla){
+
+    if(hash->cantidad == 0) return NULL;
+    if (hash->compacto) return buscar_entrada(hash, clave, largo, h, NULL);
+
+    tabla_t* t = (tabla_t*) &hash->tabla;
+    size_t pos = buscar_en_tabla(hash, t, clave, largo, h);
+    if (pos == t->capacidad && hash->vieja.capacidad){
+        t = (tabla_t*) &hash->vieja;
+        pos = buscar_en_tabla(hash, t, clave, largo, h);
+    }
+    if (pos == t->capacidad) return NULL;
+    // Un campo borrado desde un iterador sigue en la cadena hasta compactar
+    if (hash->pendientes && !bit_ocupado(t, pos)) return NULL;
+    if (tabla) *tabla = t;
+    return &t->campos[pos];
+}
+
+static inline const ranura_t* ranuras_de(const snapshot_t *snapshot){
+    return (const ranura_t*) (snapshot + 1);
+}
+
+// Busca la clave en las ranuras del snapshot como buscar_en_tabla en los
+// campos, y devuelve un puntero a los bytes de su dato o NULL si no está.
+static void *buscar_en_snapshot(const snapshot_t *snapshot, const char *clave, size_t largo, uint64_t h){
+
+    const ranura_t* ranuras = ranuras_de(snapshot);
+    size_t mascara = (size_t) snapshot->capacidad - 1;
+    size_t pos = (size_t) h & mascara;
+    for (size_t d = 0; ranuras[pos].clave; d++){
+        const ranura_t* ranura = &ranuras[pos];
+        if (((pos - ((size_t) ranura->hash & mascara)) & mascara) < d) break;
+        if (ranura->hash == h && ranura->largo == largo
+            && memcmp((const char*) snapshot + ranura->clave, clave, largo) == 0){
+            return (char*) snapshot + ranura->dato;
+        }
+        pos = (pos + 1) & mascara;
+    }
     return NULL;
-  }
+}
 
-  hash->destruir_dato=destruir_dato;
-  hash->capacidad=CAPACIDAD_INICIAL; 
-  return hash;
+static inline void escribir_campo(tabla_t *t, size_t pos, campo_t campo){
+    t->campos[pos] = campo;
+    t->ocupados[pos / BITS_POR_PALABRA] |= UINT64_C(1) << (pos % BITS_POR_PALABRA);
+    marcar_control(t, pos, etiqueta(campo.hash));
 }
 
+static inline void vaciar_campo(tabla_t *t, size_t pos){
+    memset(&t->campos[pos], 0, sizeof(campo_t));
+    t->ocupados[pos / BITS_POR_PALABRA] &= ~(UINT64_C(1) << (pos % BITS_POR_PALABRA));
+    marcar_control(t, pos, CONTROL_VACIO);
+}
 
-void *hash_obtener(const hash_t *hash, const char *clave){
-    size_t i = buscar_ocupado(hash,clave);
-    if (!hash->tabla[i] || hash->tabla[i]->estado!=OCUPADO || strcmp(hash->tabla[i]->clave,clave)!=0) return NULL;
-	return hash->tabla[i]->dato;
+static inline size_t ceros_finales(uint64_t x){
+#ifdef __GNUC__
+    return (size_t) __builtin_ctzll(x);
+#else
+    size_t n = 0;
+    for (; !(x & 1); x >>= 1) n++;
+    return n;
+#endif
 }
 
-<<<<<<< HEAD
-bool hash_pertenece(const hash_t *hash, const char *clave){
+// Devuelve la primera posición ocupada de la tabla en [pos, fin), o fin si
+// no hay.
+// Pre: fin no pasa de la capacidad
+static size_t siguiente_ocupado(const tabla_t *t, size_t pos, size_t fin){
+    if (pos >= fin) return fin;
+
+    size_t palabra = pos / BITS_POR_PALABRA;
+    size_t palabras = (fin + BITS_POR_PALABRA - 1) / BITS_POR_PALABRA;
+    uint64_t bits = t->ocupados[palabra] & (~UINT64_C(0) << (pos % BITS_POR_PALABRA));
+    while (!bits){
+        if (++palabra == palabras) return fin;
+        bits = t->ocupados[palabra];
+    }
+    size_t sig = palabra * BITS_POR_PALABRA + ceros_finales(bits);
+    return sig < fin ? sig : fin;
+}
 
-    size_t pos = (size_t) fhash(clave) % hash->capacidad;
-    while(hash->tabla[pos]->estado != VACIO){
-        if (hash->tabla[pos]->estado == OCUPADO && strcmp(hash->tabla[pos]->clave, clave) == 0){
-            return true;
-        } 
-        pos = (pos + 1) % hash->capacidad;
+// Inserta el campo, cuya clave no está en la tabla, a partir de la posición
+// pos que está a distancia d de su posición inicial, desplazando a los campos
+// que estén más cerca de la suya.
+static void insertar_campo_desde(tabla_t *t, campo_t campo, size_t pos, size_t d){
+
+    for (; t->campos[pos].estado == OCUPADO; d++){
+        size_t d_actual = distancia(t, t->campos[pos].hash, pos);
+        if (d_actual < d){
+            campo_t desplazado = t->campos[pos];
+            escribir_campo(t, pos, campo);
+            campo = desplazado;
+            d = d_actual;
+        }
+        pos = (pos + 1) & t->mascara;
     }
-    return false;
+    escribir_campo(t, pos, campo);
 }
 
-size_t hash_cantidad(const hash_t *hash){	
-	return hash->cantidad;
+static void insertar_campo(tabla_t *t, campo_t campo){
+    insertar_campo_desde(t, campo, (size_t) campo.hash & t->mascara, 0);
 }
-=======
->>>>>>> 81a106131497f70590d10ae654a716fa9404a3b7
 
-void hash_destruir(hash_t *hash){
-    size_t i = 0;
-    while (i < hash->capacidad){
-        if (!hash->tabla[i]){
-			 i++;
-			 continue;
-		}	 
-        if(hash->destruir_dato){
-            hash->destruir_dato(hash->tabla[i]->dato);
+// Recorre la cadena de la clave una sola vez, campo por campo. Devuelve su
+// posición si está; si no, devuelve la capacidad y deja en hueco y dist la
+// posición donde habría que insertarla y su distancia a la inicial.
+static size_t sondear(const tabla_t *t, const char *clave, size_t largo, uint64_t h, size_t *hueco, size_t *dist){
+
+    size_t pos = (size_t) h & t->mascara;
+    size_t d = 0;
+    for (; t->campos[pos].estado == OCUPADO; d++){
+        const campo_t* campo = &t->campos[pos];
+        if (distancia(t, campo->hash, pos) < d) break;
+        if (coincide(campo, clave, largo, h)) return pos;
+        pos = (pos + 1) & t->mascara;
+    }
+    *hueco = pos;
+    *dist = d;
+    return t->capacidad;
+}
+
+// Vacía la posición pos corriendo hacia atrás los campos que le siguen.
+static void quitar_campo(tabla_t *t, size_t pos){
+
+    size_t sig = (pos + 1) & t->mascara;
+    while (t->campos[sig].estado == OCUPADO && distancia(t, t->campos[sig].hash, sig) > 0){
+        escribir_campo(t, pos, t->campos[sig]);
+        pos = sig;
+        sig = (sig + 1) & t->mascara;
+    }
+    vaciar_campo(t, pos);
+}
+
+// Reserva una tabla vacía de la capacidad dada, con sus bytes de control si
+// el hash usa el motor de grupos.
+static bool crear_tabla(tabla_t *t, size_t capacidad, bool con_control){
+
+    campo_t* campos = calloc(capacidad, sizeof(campo_t));
+    uint64_t* ocupados = calloc((capacidad + BITS_POR_PALABRA - 1) / BITS_POR_PALABRA, sizeof(uint64_t));
+    if(!campos || !ocupados){
+        free(campos);
+        free(ocupados);
+        return false;
+    }
+
+    uint8_t* control = NULL;
+    if (con_control){
+        control = malloc(capacidad + GRUPO_MAX - 1);
+        if(!control){
+            free(campos);
+            free(ocupados);
+            return false;
         }
-<<<<<<< HEAD
-        free(hash->tabla[i]->clave);
-        free(hash->tabla[i]);
-=======
-		free(hash->tabla[i]->clave);
-        free(hash->tabla[i]); 
->>>>>>> 81a106131497f70590d10ae654a716fa9404a3b7
-        i++;
-    }
-    free(hash->tabla);
-    free(hash);
+        memset(control, CONTROL_VACIO, capacidad + GRUPO_MAX - 1);
+    }
+
+    t->campos = campos;
+    t->ocupados = ocupados;
+    t->control = control;
+    t->capacidad = capacidad;
+    t->mascara = capacidad - 1;
+    return true;
 }
 
+static void destruir_tabla(tabla_t *t){
+    free(t->campos);
+    free(t->indices);
+    free(t->ocupados);
+    free(t->control);
+    memset(t, 0, sizeof(tabla_t));
+}
 
-<<<<<<< HEAD
-size_t buscar_vacio(const hash_t *hash, const char *clave){
-	
-	size_t inicial = (size_t)fhash(clave) % hash->capacidad;
-	size_t pos = inicial;
-    if (hash->cantidad != 0){
-        for (size_t i = 1; i < hash->capacidad && hash->tabla[pos]->estado != VACIO; i++){
-            pos = (inicial + i) % hash->capacidad;
+/* ******************************************************************
+ *                        REDIMENSION
+ * *****************************************************************/
+
+/* Con redimension_incremental, redimensionar sólo crea la tabla nueva y cada
+ * hash_guardar o hash_borrar siguiente mueve PASOS_MIGRACION posiciones de
+ * la tabla vieja, recorriéndola desde una posición vacía. Un paso sólo corta
+ * antes de un campo que está en su posición inicial (o de uno vacío): así
+ * ninguna cadena de sondeo de la tabla vieja queda partida y las búsquedas y
+ * el corrimiento de hash_borrar siguen funcionando en las dos tablas. */
+
+#define PASOS_MIGRACION 128
+
+// Mueve al menos pasos posiciones de la tabla vieja a la actual. Al
+// terminar de recorrerla, la libera.
+static void migrar(hash_t *hash, size_t pasos){
+
+    tabla_t* vieja = &hash->vieja;
+    hash->modificaciones++;
+    while (hash->migrados < vieja->capacidad){
+        size_t pos = (hash->inicio_migracion + hash->migrados) & vieja->mascara;
+        campo_t* campo = &vieja->campos[pos];
+        if (pasos == 0 && (campo->estado != OCUPADO || distancia(vieja, campo->hash, pos) == 0)) return;
+
+        if (campo->estado == OCUPADO){
+            // Los borrados desde un iterador no pasan a la tabla nueva
+            if (bit_ocupado(vieja, pos)) insertar_campo(&hash->tabla, *campo);
+            else liberar_clave(hash, campo);
+            vaciar_campo(vieja, pos);
         }
+        hash->migrados++;
+        if (pasos > 0) pasos--;
     }
-	return pos;
+    destruir_tabla(vieja);
 }
 
-bool redimensionar(hash_t *hash,int criterio){
+/* hash_iter_borrar_actual no corre campos: el campo borrado sigue OCUPADO,
+ * para no partir las cadenas de sondeo, pero sin su bit en ocupados, así el
+ * iterador no lo ve y buscar_campo no lo devuelve. La próxima operación que
+ * mueve campos primero compacta: recorre la tabla una vez desde una
+ * posición vacía, vaciando los borrados y corriendo cada campo que les sigue
+ * hasta el primer lugar libre que no esté antes de su posición inicial. */
+
+static void compactar_tabla(hash_t *hash, tabla_t *t){
+
+    size_t inicio = 0;
+    while (t->campos[inicio].estado == OCUPADO) inicio++;
+
+    bool hay_libre = false;
+    size_t libre = 0;
+    for (size_t i = 1; i < t->capacidad; i++){
+        size_t pos = (inicio + i) & t->mascara;
+        campo_t* campo = &t->campos[pos];
+        if (campo->estado != OCUPADO){
+            hay_libre = false;
+            continue;
+        }
+        if (!bit_ocupado(t, pos)){
+            liberar_clave(hash, campo);
+            vaciar_campo(t, pos);
+            if (!hay_libre) libre = pos;
+            hay_libre = true;
+            continue;
+        }
+        if (!hay_libre) continue;
+
+        size_t d = distancia(t, campo->hash, pos);
+        if (d == 0){
+            hay_libre = false;
+            continue;
+        }
+        size_t destino = ((pos - libre) & t->mascara) <= d ? libre : (pos - d) & t->mascara;
+        escribir_campo(t, destino, *campo);
+        vaciar_campo(t, pos);
+        libre = (destino + 1) & t->mascara;
+    }
+}
 
-    size_t capacidad_anterior = hash->capacidad;
-    if(criterio == AGRANDAR) hash->capacidad = (hash->capacidad * 2) + 1;
-    if(criterio == REDUCIR) hash->capacidad = hash->capacidad / 2;
-	
-    campo_t** tabla_nueva = calloc(hash->capacidad,sizeof(campo_t));
-    if(!tabla_nueva) return NULL;
-    campo_t** tabla_vieja = hash->tabla;
-    hash->tabla = tabla_nueva;
+// Quita los campos borrados desde un iterador. Los de la tabla vieja se
+// quitan al terminar la migración.
+static void compactar(hash_t *hash){
+    if (!hash->pendientes) return;
+    compactar_tabla(hash, &hash->tabla);
+    if (hash->vieja.capacidad) migrar(hash, SIZE_MAX);
+    hash->pendientes = 0;
+    hash->modificaciones++;
+}
 
-    //Recorro la tabla y creo los campos inicialmente en estado VACIO
-    for (size_t i = 0; i < hash->capacidad; i++){
-        campo_t* campo = malloc(sizeof(campo_t));
-        if(!campo){
-            free(hash->tabla);
-            return NULL;
-        } 
-        campo->estado = VACIO;
-        campo->clave = NULL;
-        campo->dato = NULL;
-        hash->tabla[i] = campo;
+// Devuelve la menor capacidad que guarda cantidad elementos sin agrandarse,
+// o 0 si una tabla de esa capacidad no se puede pedir.
+static size_t capacidad_para(const hash_t *hash, size_t cantidad){
+    size_t capacidad = CAPACIDAD_INICIAL;
+    while (((double) cantidad + 1) / (double) capacidad >= hash->politica.carga_maxima){
+        if (capacidad > SIZE_MAX / sizeof(campo_t) / 2) return 0;
+        capacidad *= 2;
     }
+    return capacidad;
+}
 
-    size_t pos;
-    for(size_t i = 0; i <capacidad_anterior; i++){ //recorro tabla vieja
-        if(tabla_vieja[i]->estado == OCUPADO){ //agrego en tabla nueva en espacio vacio
-            pos = (size_t) fhash(tabla_vieja[i]->clave) % hash->capacidad;
-            while(hash->tabla[pos]->estado != VACIO){
-                pos++;
+/* Con un pool, las redimensiones de tablas grandes y hash_construir colocan
+ * los campos en paralelo. La tabla nueva se parte en regiones contiguas y
+ * cada campo va a la región de su posición inicial. Como Robin Hood sin
+ * borrados deja cada cadena ordenada por posición inicial (y las iguales en
+ * orden de llegada), cada región se arma ordenando sus campos por (posición
+ * inicial, orden) y poniéndolos uno detrás de otro, sin desplazar a nadie.
+ * Los que no llegan a entrar antes del final de su región se insertan
+ * después, de a uno y con el algoritmo de siempre. */
+
+#define REGIONES_POR_HILO 4
+// Cantidad de elementos desde la que conviene repartir el trabajo
+#define MINIMO_PARALELO 16384
+
+typedef struct item {
+    size_t pos;     // posición inicial en la tabla nueva
+    size_t orden;   // índice del campo en el origen
+} item_t;
+
+typedef struct colocacion {
+    tabla_t* tabla;
+    campo_t* origen;        // los campos que no están OCUPADO se ignoran
+    size_t n;
+    bool repetidas;         // puede haber claves repetidas en el origen
+    size_t bloques;         // partes del origen para contar y repartir
+    size_t regiones;
+    unsigned corrimiento;   // la región de pos es pos >> corrimiento
+    size_t* cuentas;        // bloques x regiones
+    item_t* items;          // agrupados por región
+    size_t* inicio_region;  // regiones + 1
+    size_t* desborde;       // primer item de cada región que no entró
+    size_t* colocados;
+} colocacion_t;
+
+static inline void rango_de_bloque(const colocacion_t *c, size_t bloque, size_t *desde, size_t *hasta){
+    *desde = c->n * bloque / c->bloques;
+    *hasta = c->n * (bloque + 1) / c->bloques;
+}
+
+static void contar_bloque(void *extra, size_t bloque){
+    colocacion_t* c = extra;
+    size_t* cuentas = &c->cuentas[bloque * c->regiones];
+    size_t desde, hasta;
+    rango_de_bloque(c, bloque, &desde, &hasta);
+    for (size_t i = desde; i < hasta; i++){
+        if (c->origen[i].estado != OCUPADO) continue;
+        cuentas[((size_t) c->origen[i].hash & c->tabla->mascara) >> c->corrimiento]++;
+    }
+}
+
+// Copia cada item a su región, en el lugar que le deja la suma de las
+// cuentas de las regiones y bloques anteriores.
+static void repartir_bloque(void *extra, size_t bloque){
+    colocacion_t* c = extra;
+    size_t* siguiente = &c->cuentas[bloque * c->regiones];
+    size_t desde, hasta;
+    rango_de_bloque(c, bloque, &desde, &hasta);
+    for (size_t i = desde; i < hasta; i++){
+        if (c->origen[i].estado != OCUPADO) continue;
+        size_t pos = (size_t) c->origen[i].hash & c->tabla->mascara;
+        c->items[siguiente[pos >> c->corrimiento]++] = (item_t) {pos, i};
+    }
+}
+
+static int comparar_items(const void *a, const void *b){
+    const item_t* x = a;
+    const item_t* y = b;
+    if (x->pos != y->pos) return x->pos < y->pos ? -1 : 1;
+    return x->orden < y->orden ? -1 : x->orden > y->orden;
+}
+
+// Marca VACIO en el origen a cada campo que tiene más adelante otro con la
+// misma clave, como si el último lo hubiera reemplazado. Las claves iguales
+// tienen la misma posición inicial, así que quedan juntas en el orden.
+static void descartar_repetidas(colocacion_t *c, size_t desde, size_t hasta){
+    for (size_t i = desde + 1; i < hasta; i++){
+        const campo_t* campo = &c->origen[c->items[i].orden];
+        for (size_t j = i; j-- > desde && c->items[j].pos == c->items[i].pos;){
+            campo_t* anterior = &c->origen[c->items[j].orden];
+            if (anterior->estado == OCUPADO && coincide(anterior, clave_de(campo), campo->largo, campo->hash)){
+                anterior->estado = VACIO;
+                break;
             }
-            free(hash->tabla[pos]);
-            hash->tabla[pos] = tabla_vieja[i];
-            continue;
         }
-        free(tabla_vieja[i]);
     }
-    free(tabla_vieja);
-    hash->borrados = BORRADOS_INICIAL;
+}
+
+// Ordena los items de la región por posición inicial. El reparto los deja
+// en orden de llegada, así que alcanza un conteo estable; si no hay memoria
+// para el conteo, usa qsort.
+static void ordenar_region(colocacion_t *c, size_t region, size_t desde, size_t hasta){
+    size_t ancho = (size_t) 1 << c->corrimiento;
+    size_t base = region << c->corrimiento;
+    size_t* cuentas = calloc(ancho + 1, sizeof(size_t));
+    item_t* ordenados = malloc((hasta - desde) * sizeof(item_t) + 1);
+    if (!cuentas || !ordenados){
+        qsort(&c->items[desde], hasta - desde, sizeof(item_t), comparar_items);
+    } else {
+        for (size_t i = desde; i < hasta; i++) cuentas[c->items[i].pos - base + 1]++;
+        for (size_t i = 1; i <= ancho; i++) cuentas[i] += cuentas[i - 1];
+        for (size_t i = desde; i < hasta; i++) ordenados[cuentas[c->items[i].pos - base]++] = c->items[i];
+        memcpy(&c->items[desde], ordenados, (hasta - desde) * sizeof(item_t));
+    }
+    free(cuentas);
+    free(ordenados);
+}
+
+static void colocar_region(void *extra, size_t region){
+    colocacion_t* c = extra;
+    size_t desde = c->inicio_region[region], hasta = c->inicio_region[region + 1];
+    ordenar_region(c, region, desde, hasta);
+    if (c->repetidas) descartar_repetidas(c, desde, hasta);
+
+    size_t pos = region << c->corrimiento;
+    size_t fin = (region + 1) << c->corrimiento;
+    size_t colocados = 0;
+    size_t i = desde;
+    for (; i < hasta; i++){
+        const campo_t* campo = &c->origen[c->items[i].orden];
+        if (campo->estado != OCUPADO) continue;
+        if (c->items[i].pos > pos) pos = c->items[i].pos;
+        if (pos == fin) break;
+        escribir_campo(c->tabla, pos++, *campo);
+        colocados++;
+    }
+    c->desborde[region] = i;
+    c->colocados[region] = colocados;
+}
+
+// Coloca en la tabla t, vacía, los campos ocupados de origen[0..n) usando el
+// pool, y deja en cantidad cuántos quedaron. Con repetidas, de cada clave
+// queda el último campo y los anteriores se marcan VACIO en el origen.
+// Devuelve false, sin tocar la tabla, si no hay memoria para los auxiliares.
+static bool colocar_en_paralelo(hash_t *hash, tabla_t *t, campo_t *origen, size_t n, bool repetidas, size_t *cantidad){
+
+    size_t hilos = pool_hilos(hash->pool);
+    colocacion_t c = {
+        .tabla = t,
+        .origen = origen,
+        .n = n,
+        .repetidas = repetidas,
+        .bloques = hilos * REGIONES_POR_HILO,
+        .regiones = 1,
+    };
+    // Cada región ocupa palabras enteras de ocupados, así dos hilos no
+    // escriben la misma
+    while (c.regiones < hilos * REGIONES_POR_HILO && c.regiones * BITS_POR_PALABRA < t->capacidad) c.regiones *= 2;
+    while (((size_t) 1 << c.corrimiento) * c.regiones < t->capacidad) c.corrimiento++;
+
+    c.cuentas = calloc(c.bloques * c.regiones, sizeof(size_t));
+    c.items = malloc(n * sizeof(item_t) + 1);
+    c.inicio_region = malloc((c.regiones + 1) * sizeof(size_t));
+    c.desborde = malloc(c.regiones * sizeof(size_t));
+    c.colocados = malloc(c.regiones * sizeof(size_t));
+    bool ok = c.cuentas && c.items && c.inicio_region && c.desborde && c.colocados;
+
+    if (ok){
+        pool_ejecutar(hash->pool, contar_bloque, &c, c.bloques);
+
+        // Las cuentas pasan a ser el lugar del primer item de cada bloque en
+        // cada región
+        size_t total = 0;
+        for (size_t r = 0; r < c.regiones; r++){
+            c.inicio_region[r] = total;
+            for (size_t b = 0; b < c.bloques; b++){
+                size_t cuenta = c.cuentas[b * c.regiones + r];
+                c.cuentas[b * c.regiones + r] = total;
+                total += cuenta;
+            }
+        }
+        c.inicio_region[c.regiones] = total;
+
+        pool_ejecutar(hash->pool, repartir_bloque, &c, c.bloques);
+        pool_ejecutar(hash->pool, colocar_region, &c, c.regiones);
+
+        *cantidad = 0;
+        for (size_t r = 0; r < c.regiones; r++){
+            *cantidad += c.colocados[r];
+            for (size_t i = c.desborde[r]; i < c.inicio_region[r + 1]; i++){
+                const campo_t* campo = &origen[c.items[i].orden];
+                if (campo->estado != OCUPADO) continue;
+                insertar_campo(t, *campo);
+                (*cantidad)++;
+            }
+        }
+    }
+
+    free(c.cuentas);
+    free(c.items);
+    free(c.inicio_region);
+    free(c.desborde);
+    free(c.colocados);
+    return ok;
+}
+
+// Pasa los elementos a una tabla nueva de la capacidad dada, de a poco si
+// incremental es true.
+static bool redimensionar_a(hash_t *hash, size_t capacidad_nueva, bool incremental){
+
+    if (hash->compacto) return reindexar(hash, capacidad_nueva);
+    compactar(hash);
+    hash->modificaciones++;
+
+    // Nunca hay más de una migración a la vez
+    if (hash->vieja.capacidad) migrar(hash, SIZE_MAX);
+
+    tabla_t vieja = hash->tabla;
+    if(!crear_tabla(&hash->tabla, capacidad_nueva, hash->con_control)) return false;
+
+    if (incremental){
+        hash->vieja = vieja;
+        hash->migrados = 0;
+        hash->inicio_migracion = 0;
+        while (vieja.campos[hash->inicio_migracion].estado == OCUPADO) hash->inicio_migracion++;
+        migrar(hash, PASOS_MIGRACION);
+        return true;
+    }
+
+    size_t colocados;
+    if (hash->pool && pool_hilos(hash->pool) > 1 && hash->cantidad >= MINIMO_PARALELO
+        && colocar_en_paralelo(hash, &hash->tabla, vieja.campos, vieja.capacidad, false, &colocados)){
+        destruir_tabla(&vieja);
+        return true;
+    }
+
+    //Muevo los campos ocupados a la tabla nueva, sin copiar ni hashear las claves
+    for(size_t i = siguiente_ocupado(&vieja, 0, vieja.capacidad); i < vieja.capacidad; i = siguiente_ocupado(&vieja, i + 1, vieja.capacidad)){
+        insertar_campo(&hash->tabla, vieja.campos[i]);
+    }
+    destruir_tabla(&vieja);
+    return true;
+}
+
+/* Al agrandar, la capacidad se multiplica por el factor de crecimiento. Al
+ * achicar se divide por dos mientras la carga resultante quede por debajo de
+ * carga_maxima - histeresis: si no hay ese margen, no se achica, y así una
+ * carga que oscila cerca de carga_minima no alterna entre agrandar y achicar. */
+static bool redimensionar(hash_t *hash, criterio_t criterio){
+
+    const hash_politica_t* politica = &hash->politica;
+    size_t capacidad_nueva = hash->tabla.capacidad;
+    if(criterio == AGRANDAR) capacidad_nueva = hash->tabla.capacidad * politica->factor_crecimiento;
+    if(criterio == REDUCIR){
+        double tope = politica->carga_maxima - politica->histeresis;
+        while (capacidad_nueva / 2 >= CAPACIDAD_INICIAL
+               && (double) (hash->cantidad + 1) / (double) (capacidad_nueva / 2) < tope){
+            capacidad_nueva /= 2;
+        }
+        if (capacidad_nueva == hash->tabla.capacidad) return true;
+    }
+    return redimensionar_a(hash, capacidad_nueva, hash->incremental);
+}
+
+/* ******************************************************************
+ *                        PRIMITIVAS HASH
+ * *****************************************************************/
+
+hash_politica_t hash_politica_por_defecto(void){
+    hash_politica_t politica = {
+        .carga_maxima = VALOR_AGRANDAR,
+        .carga_minima = VALOR_REDUCIR,
+        .factor_crecimiento = FACTOR_CRECIMIENTO,
+        .reducir = true,
+        .histeresis = HISTERESIS,
+    };
+    return politica;
+}
+
+// Verifica que la política tenga sentido y redondea el factor de
+// crecimiento a una potencia de dos.
+static bool normalizar_politica(hash_politica_t *politica){
+    if (!(politica->carga_maxima > 0 && politica->carga_maxima <= CARGA_MAXIMA_TOPE)) return false;
+    if (politica->reducir && !(politica->carga_minima >= 0 && politica->carga_minima < politica->carga_maxima)) return false;
+    if (!(politica->histeresis >= 0 && politica->histeresis < politica->carga_maxima)) return false;
+    if (politica->factor_crecimiento < 2 || politica->factor_crecimiento > FACTOR_CRECIMIENTO_MAX) return false;
+
+    size_t factor = 2;
+    while (factor < politica->factor_crecimiento) factor *= 2;
+    politica->factor_crecimiento = factor;
     return true;
 }
 
+bool hash_cambiar_politica(hash_t *hash, const hash_politica_t *politica){
+    hash_politica_t nueva = *politica;
+    if (!normalizar_politica(&nueva)) return false;
+    hash->politica = nueva;
+    return true;
+}
+
+hash_t *hash_crear(hash_destruir_dato_t destruir_dato){
+    hash_opciones_t opciones = {
+        .destruir_dato = destruir_dato,
+    };
+    return hash_crear_con_opciones(&opciones);
+}
+
+hash_t *hash_crear_con_capacidad(hash_destruir_dato_t destruir_dato, size_t cantidad){
+    hash_opciones_t opciones = {
+        .destruir_dato = destruir_dato,
+        .capacidad = cantidad,
+    };
+    return hash_crear_con_opciones(&opciones);
+}
+
+hash_t *hash_crear_con_opciones(const hash_opciones_t *opciones){
+
+    hash_t* hash = calloc(1,sizeof(hash_t));
+    if(!hash) return NULL;
+
+    hash->politica = opciones->politica ? *opciones->politica : hash_politica_por_defecto();
+    bool combinables = !opciones->compacto || (opciones->motor == HASH_MOTOR_LINEAL && !opciones->redimension_incremental);
+    if(!normalizar_politica(&hash->politica) || !combinables){
+        free(hash);
+        return NULL;
+    }
+
+    if(opciones->arena_claves){
+        hash->arena = arena_crear();
+        if(!hash->arena){
+            free(hash);
+            return NULL;
+        }
+    }
+
+    hash->con_control = opciones->motor == HASH_MOTOR_GRUPOS;
+    hash->compacto = opciones->compacto;
+    size_t capacidad = capacidad_para(hash, opciones->capacidad);
+    bool creada = !capacidad ? false : hash->compacto ? crear_indices(&hash->tabla, capacidad) && reservar_entradas(hash, opciones->capacidad)
+                                 : crear_tabla(&hash->tabla, capacidad, hash->con_control);
+    if(!creada){
+        destruir_tabla(&hash->tabla);
+        if(hash->arena) arena_destruir(hash->arena);
+        free(hash);
+        return NULL;
+    }
+
+    hash->destruir_dato = opciones->destruir_dato;
+    hash->funcion_hash = opciones->funcion_hash ? opciones->funcion_hash : hash_funcion_rapida;
+    hash->semilla = opciones->semilla;
+    hash->incremental = opciones->redimension_incremental;
+    hash->pool = opciones->pool;
+    if (hash->con_control) hash->ancho_grupo = elegir_ancho_grupo();
+    return hash;
+}
+
+uint64_t hash_calcular(const hash_t *hash, const char *clave){
+    return calcular_hash(hash, clave, strlen(clave));
+}
+
+uint64_t hash_calcular_bin(const hash_t *hash, const void *clave, size_t largo){
+    return calcular_hash(hash, clave, largo);
+}
+
+void *hash_obtener(const hash_t *hash, const char *clave){
+    return hash_obtener_h(hash, clave, hash_calcular(hash, clave));
+}
+
+void *hash_obtener_h(const hash_t *hash, const char *clave, uint64_t h){
+    if (hash->snapshot) return buscar_en_snapshot(hash->snapshot, clave, strlen(clave), h);
+    campo_t* campo = buscar_campo(hash, clave, strlen(clave), h, NULL);
+    return campo ? campo->dato : NULL;
+}
+
+void *hash_obtener_bin(const hash_t *hash, const void *clave, size_t largo){
+    uint64_t h = calcular_hash(hash, clave, largo);
+    if (hash->snapshot) return buscar_en_snapshot(hash->snapshot, clave, largo, h);
+    campo_t* campo = buscar_campo(hash, clave, largo, h, NULL);
+    return campo ? campo->dato : NULL;
+}
+
+bool hash_pertenece(const hash_t *hash, const char *clave){
+    return hash_pertenece_h(hash, clave, hash_calcular(hash, clave));
+}
+
+bool hash_pertenece_h(const hash_t *hash, const char *clave, uint64_t h){
+    if (hash->snapshot) return buscar_en_snapshot(hash->snapshot, clave, strlen(clave), h) != NULL;
+    return buscar_campo(hash, clave, strlen(clave), h, NULL) != NULL;
+}
+
+bool hash_pertenece_bin(const hash_t *hash, const void *clave, size_t largo){
+    uint64_t h = calcular_hash(hash, clave, largo);
+    if (hash->snapshot) return buscar_en_snapshot(hash->snapshot, clave, largo, h) != NULL;
+    return buscar_campo(hash, clave, largo, h, NULL) != NULL;
+}
+
+size_t hash_cantidad(const hash_t *hash){
+	return hash->cantidad;
+}
+
+// Llama a destruir_dato y libera la clave de cada campo ocupado de la tabla.
+static void destruir_campos(hash_t *hash, tabla_t *t){
+    // Con arena las claves se liberan todas juntas con sus páginas
+    if(!hash->destruir_dato && hash->arena) return;
+    for (size_t i = siguiente_ocupado(t, 0, t->capacidad); i < t->capacidad; i = siguiente_ocupado(t, i + 1, t->capacidad)){
+        if(hash->destruir_dato){
+            hash->destruir_dato(t->campos[i].dato);
+        }
+        if(!hash->arena) liberar_clave(hash, &t->campos[i]);
+    }
+}
+
+void hash_destruir(hash_t *hash){
+    if (hash->snapshot){
+        munmap((void*) hash->snapshot, hash->snapshot->largo);
+        free(hash);
+        return;
+    }
+    compactar(hash);
+    if (hash->compacto) destruir_entradas(hash);
+    else {
+        destruir_campos(hash, &hash->vieja);
+        destruir_campos(hash, &hash->tabla);
+    }
+    if(hash->arena) arena_destruir(hash->arena);
+    destruir_tabla(&hash->vieja);
+    destruir_tabla(&hash->tabla);
+    free(hash);
+}
+
+// borrar, guardar, obtener_o_insertar y actualizar_dato trabajan sobre la
+// clave de largo bytes con hash h; las primitivas calculan lo que les falta.
+static void *borrar(hash_t *hash, const char *clave, size_t largo, uint64_t h){
+
+    if (hash->snapshot) return NULL;
+    compactar(hash);
+    void* dato;
+    if (hash->compacto){
+        size_t pos;
+        campo_t* entrada = buscar_entrada(hash, clave, largo, h, &pos);
+        if(!entrada) return NULL;
+
+        dato = entrada->dato;
+        quitar_entrada(hash, entrada, pos);
+    } else {
+        tabla_t* t;
+        campo_t* campo = buscar_campo(hash, clave, largo, h, &t);
+        if(!campo) return NULL;
+
+        dato = campo->dato;
+        liberar_clave(hash, campo);
+        quitar_campo(t, (size_t) (campo - t->campos));
+    }
+    hash->cantidad--;
+    hash->modificaciones++;
+    if (hash->vieja.capacidad) migrar(hash, PASOS_MIGRACION);
+
+    double carga= (double) hash->cantidad / (double) hash->tabla.capacidad;
+    if (hash->politica.reducir && carga <= hash->politica.carga_minima
+        && hash->tabla.capacidad != CAPACIDAD_INICIAL)	redimensionar(hash,REDUCIR);
+
+    return dato;
+}
+
 void *hash_borrar(hash_t *hash, const char *clave){
-	
-	if(!hash_pertenece(hash,clave)) return NULL;
+    return hash_borrar_h(hash, clave, hash_calcular(hash, clave));
+}
+
+void *hash_borrar_h(hash_t *hash, const char *clave, uint64_t h){
+    return borrar(hash, clave, strlen(clave), h);
+}
+
+void *hash_borrar_bin(hash_t *hash, const void *clave, size_t largo){
+    return borrar(hash, clave, largo, calcular_hash(hash, clave, largo));
+}
+
+// Reemplaza el dato del campo, destruyendo el anterior.
+static void reemplazar_dato(hash_t *hash, campo_t *campo, void *dato){
+    if(hash->destruir_dato) hash->destruir_dato(campo->dato);
+    campo->dato = dato;
+}
+
+// Prepara el hash para una operación que agrega una clave: avanza la
+// migración pendiente y agranda la tabla si un elemento más no entra.
+static bool preparar_escritura(hash_t *hash){
+    compactar(hash);
+    if (hash->vieja.capacidad) migrar(hash, PASOS_MIGRACION);
+
+    double carga= (double)(hash->cantidad + 1)/ (double) hash->tabla.capacidad;
+    if (carga >= hash->politica.carga_maxima && !redimensionar(hash,AGRANDAR)) return false;
+    return !hash->compacto || lugar_para_entrada(hash);
+}
 
-    size_t pos = (size_t)fhash(clave) % hash->capacidad;
-	void* dato = hash_obtener(hash,clave);
+// Dice si se puede agregar un elemento sin compactar, migrar ni agrandar.
+static bool escritura_lista(const hash_t *hash){
+    if (hash->pendientes || hash->vieja.capacidad) return false;
+    double carga= (double)(hash->cantidad + 1)/ (double) hash->tabla.capacidad;
+    if (carga >= hash->politica.carga_maxima) return false;
+    return !hash->compacto || hash->usadas < hash->capacidad_entradas;
+}
+
+// Como ubicar, pero sin preparar la tabla: la cadena se recorre una sola
+// vez y la clave nueva va en la posición donde terminó la búsqueda.
+// Pre: no hay migración ni borrados pendientes y hay lugar para un elemento
+// más sin pasar la carga máxima.
+static campo_t* ubicar_preparado(hash_t *hash, const char *clave, size_t largo, uint64_t h, bool *insertado){
+
+    if (hash->compacto) return ubicar_compacto(hash, clave, largo, h, insertado);
+    *insertado = false;
+    tabla_t* t = &hash->tabla;
+    size_t hueco = 0, dist = 0;
+    size_t pos = sondear(t, clave, largo, h, &hueco, &dist);
+    if (pos != t->capacidad) return &t->campos[pos];
+
+    //Guardo la copia de la clave en el campo
+    campo_t nuevo = {
+        .hash = h,
+        .estado = OCUPADO,
+    };
+    if(!copiar_clave(hash, &nuevo, clave, largo)) return NULL;
+
+    insertar_campo_desde(t, nuevo, hueco, dist);
+    hash->cantidad ++;
+    hash->modificaciones++;
+    *insertado = true;
+    return &t->campos[hueco];
+}
+
+// Devuelve el campo de la clave. Si no estaba, la agrega con dato NULL y
+// pone insertado en true. Una clave que ya estaba se devuelve sin mover
+// nada, así reemplazar su dato no invalida los iteradores. En el caso común
+// no hace falta preparar la tabla y alcanza con ubicar_preparado. Devuelve
+// NULL si no hay memoria o el hash es un snapshot.
+static campo_t* ubicar(hash_t *hash, const char *clave, size_t largo, uint64_t h, bool *insertado){
+
+    *insertado = false;
+    if (hash->snapshot) return NULL;
+    if (!escritura_lista(hash)){
+        // La clave se busca también en la tabla vieja antes de migrar
+        campo_t* campo = buscar_campo(hash, clave, largo, h, NULL);
+        if (campo) return campo;
+        if (!preparar_escritura(hash)) return NULL;
+    }
+    return ubicar_preparado(hash, clave, largo, h, insertado);
+}
 
-	if (hash->destruir_dato){
-		hash->destruir_dato(hash->tabla[pos]->dato);
-	}
-    free(hash->tabla[pos]->clave);
-	hash->tabla[pos]->estado = BORRADO;
-	hash->tabla[pos]->clave = NULL;
-	hash->cantidad--;
-	hash->borrados++;
-	
-	float carga= (float)(hash->cantidad+ hash->borrados)/ (float) hash->capacidad;
-	if (carga <= VALOR_REDUCIR && hash->capacidad != CAPACIDAD_INICIAL)	redimensionar(hash,REDUCIR);
+static bool guardar(hash_t *hash, const char *clave, size_t largo, uint64_t h, void *dato){
+    //si la clave ya esta guardada, reemplazo el dato
+    bool insertado;
+    campo_t* campo = ubicar(hash, clave, largo, h, &insertado);
+    if (!campo) return false;
 
-	return dato;
+    if (insertado) campo->dato = dato;
+    else reemplazar_dato(hash, campo, dato);
+    return true;
 }
 
 bool hash_guardar(hash_t *hash, const char *clave, void *dato){
-    size_t pos = (size_t) fhash(clave) % hash->capacidad;
-    //veo si la clave ya esta guardada, si es así, la reemplazo
-    if (hash_pertenece(hash,clave)){
-        if(hash->destruir_dato) free(hash->tabla[pos]->dato);
-        hash->tabla[pos]->dato = dato;
-		hash->tabla[pos]->estado= OCUPADO;
+    return hash_guardar_h(hash, clave, hash_calcular(hash, clave), dato);
+}
+
+bool hash_guardar_h(hash_t *hash, const char *clave, uint64_t h, void *dato){
+    return guardar(hash, clave, strlen(clave), h, dato);
+}
+
+bool hash_guardar_bin(hash_t *hash, const void *clave, size_t largo, void *dato){
+    return guardar(hash, clave, largo, calcular_hash(hash, clave, largo), dato);
+}
+
+static void **obtener_o_insertar(hash_t *hash, const char *clave, size_t largo, uint64_t h, bool *insertado){
+    campo_t* campo = ubicar(hash, clave, largo, h, insertado);
+    return campo ? &campo->dato : NULL;
+}
+
+void **hash_obtener_o_insertar(hash_t *hash, const char *clave, bool *insertado){
+    return hash_obtener_o_insertar_h(hash, clave, hash_calcular(hash, clave), insertado);
+}
+
+void **hash_obtener_o_insertar_h(hash_t *hash, const char *clave, uint64_t h, bool *insertado){
+    return obtener_o_insertar(hash, clave, strlen(clave), h, insertado);
+}
+
+void **hash_obtener_o_insertar_bin(hash_t *hash, const void *clave, size_t largo, bool *insertado){
+    return obtener_o_insertar(hash, clave, largo, calcular_hash(hash, clave, largo), insertado);
+}
+
+static bool actualizar_dato(hash_t *hash, const char *clave, size_t largo, uint64_t h, hash_actualizar_dato_t actualizar, void *extra){
+    bool insertado;
+    campo_t* campo = ubicar(hash, clave, largo, h, &insertado);
+    if (!campo) return false;
+
+    campo->dato = actualizar(clave_de(campo), campo->dato, !insertado, extra);
+    return true;
+}
+
+bool hash_actualizar(hash_t *hash, const char *clave, hash_actualizar_dato_t actualizar, void *extra){
+    return hash_actualizar_h(hash, clave, hash_calcular(hash, clave), actualizar, extra);
+}
+
+bool hash_actualizar_h(hash_t *hash, const char *clave, uint64_t h, hash_actualizar_dato_t actualizar, void *extra){
+    return actualizar_dato(hash, clave, strlen(clave), h, actualizar, extra);
+}
+
+bool hash_actualizar_bin(hash_t *hash, const void *clave, size_t largo, hash_actualizar_dato_t actualizar, void *extra){
+    return actualizar_dato(hash, clave, largo, calcular_hash(hash, clave, largo), actualizar, extra);
+}
+
+bool hash_reservar(hash_t *hash, size_t cantidad){
+    if (hash->snapshot) return false;
+    size_t capacidad = capacidad_para(hash, cantidad);
+    if (!capacidad) return false;
+    compactar(hash);
+    if (hash->compacto && cantidad > hash->cantidad){
+        // Las entradas nuevas van después de las usadas, borradas incluidas:
+        // si no entran, primero junto las vivas
+        size_t faltan = cantidad - hash->cantidad;
+        if (hash->usadas + faltan > hash->capacidad_entradas && hash->usadas > hash->cantidad
+            && !reindexar(hash, hash->tabla.capacidad)) return false;
+        if (!reservar_entradas(hash, hash->usadas + faltan)) return false;
+    }
+    if (capacidad <= hash->tabla.capacidad){
+        // Alcanza con la tabla actual, pero no con una migración pendiente
+        if (hash->vieja.capacidad) migrar(hash, SIZE_MAX);
         return true;
     }
+    return redimensionar_a(hash, capacidad, false);
+}
 
-    // Veo si tengo que redimensionar la tabla
-	float carga= (float)(hash->cantidad + hash->borrados)/ (float) hash->capacidad;
-	if (carga >= VALOR_AGRANDAR) redimensionar(hash,AGRANDAR);
+/* hash_guardar_lote procesa las claves de a LOTE: primero calcula todos los
+ * hashes y después inserta, pidiendo con anticipación la línea de cache de
+ * la posición inicial de la clave que viene DISTANCIA_PREFETCH más adelante. */
 
-    pos = buscar_vacio(hash,clave); //si hay colición, busco pos vacía
+#define LOTE 256
+#define DISTANCIA_PREFETCH 8
 
-    //Reservo memoria para la clave, guardo la clave
-    char* copia_clave = malloc(sizeof(char) + strlen(clave));
-    if(!copia_clave) return NULL;
-    strcpy(copia_clave,clave);
-    hash->tabla[pos]->clave = copia_clave;
-    
+bool hash_guardar_lote(hash_t *hash, const char *claves[], void *datos[], size_t n){
 
-    hash->tabla[pos]->dato = dato;
-    hash->tabla[pos]->estado= OCUPADO;
-    hash->cantidad ++;
+    if (!hash_reservar(hash, hash->cantidad + n)) return false;
+
+    size_t largos[LOTE];
+    uint64_t hashes[LOTE];
+    for (size_t base = 0; base < n; base += LOTE){
+        size_t cant = n - base < LOTE ? n - base : LOTE;
+        for (size_t i = 0; i < cant; i++){
+            largos[i] = strlen(claves[base + i]);
+            hashes[i] = calcular_hash(hash, claves[base + i], largos[i]);
+        }
+
+        for (size_t i = 0; i < cant; i++){
+            if (i + DISTANCIA_PREFETCH < cant){
+                size_t pos = (size_t) hashes[i + DISTANCIA_PREFETCH] & hash->tabla.mascara;
+                if (hash->compacto) __builtin_prefetch(&hash->tabla.indices[pos]);
+                else __builtin_prefetch(&hash->tabla.campos[pos]);
+            }
+            // hash_reservar ya dejó lugar para todo el lote
+            bool insertado;
+            campo_t* campo = ubicar_preparado(hash, claves[base + i], largos[i], hashes[i], &insertado);
+            if (!campo) return false;
+
+            if (insertado) campo->dato = datos[base + i];
+            else reemplazar_dato(hash, campo, datos[base + i]);
+        }
+    }
     return true;
 }
 
+/* hash_obtener_lote también calcula los hashes de a LOTE. Mientras resuelve
+ * la clave i pide la posición inicial de la i + 2 * DISTANCIA_PREFETCH y,
+ * de la i + DISTANCIA_PREFETCH, cuya posición ya debería estar en cache, lo
+ * que esa posición referencia: la entrada con compacto o la clave guardada
+ * aparte. Así los fallos de cache de varias búsquedas se superponen. */
+
+// Pide la línea de la posición inicial de h.
+static void adelantar_posicion(const hash_t *hash, uint64_t h){
+    if (hash->snapshot){
+        __builtin_prefetch(&ranuras_de(hash->snapshot)[(size_t) h & (hash->snapshot->capacidad - 1)]);
+        return;
+    }
+    size_t pos = (size_t) h & hash->tabla.mascara;
+    if (hash->compacto) __builtin_prefetch(&hash->tabla.indices[pos]);
+    else __builtin_prefetch(&hash->tabla.campos[pos]);
+    if (hash->tabla.control) __builtin_prefetch(&hash->tabla.control[pos]);
+}
+
+// Pide lo que referencia la posición inicial de h.
+static void adelantar_referencia(const hash_t *hash, uint64_t h){
+    if (hash->snapshot){
+        const ranura_t* ranura = &ranuras_de(hash->snapshot)[(size_t) h & (hash->snapshot->capacidad - 1)];
+        if (ranura->clave) __builtin_prefetch((const char*) hash->snapshot + ranura->clave);
+        return;
+    }
+    size_t pos = (size_t) h & hash->tabla.mascara;
+    if (hash->compacto){
+        uint32_t indice = hash->tabla.indices[pos];
+        if (indice != INDICE_VACIO) __builtin_prefetch(&hash->entradas[indice - 1]);
+        return;
+    }
+    const campo_t* campo = &hash->tabla.campos[pos];
+    if (campo->estado == OCUPADO && campo->largo > HASH_LARGO_CLAVE_INLINE) __builtin_prefetch(campo->clave.externa);
+}
+
+size_t hash_obtener_lote(const hash_t *hash, const char *claves[], size_t n, void *resultados[]){
+
+    size_t encontradas = 0;
+    size_t largos[LOTE];
+    uint64_t hashes[LOTE];
+    for (size_t base = 0; base < n; base += LOTE){
+        size_t cant = n - base < LOTE ? n - base : LOTE;
+        for (size_t i = 0; i < cant; i++){
+            largos[i] = strlen(claves[base + i]);
+            hashes[i] = calcular_hash(hash, claves[base + i], largos[i]);
+            if (i < 2 * DISTANCIA_PREFETCH) adelantar_posicion(hash, hashes[i]);
+        }
+
+        for (size_t i = 0; i < cant; i++){
+            if (i + 2 * DISTANCIA_PREFETCH < cant) adelantar_posicion(hash, hashes[i + 2 * DISTANCIA_PREFETCH]);
+            if (i + DISTANCIA_PREFETCH < cant) adelantar_referencia(hash, hashes[i + DISTANCIA_PREFETCH]);
+
+            if (hash->snapshot){
+                resultados[base + i] = buscar_en_snapshot(hash->snapshot, claves[base + i], largos[i], hashes[i]);
+                encontradas += resultados[base + i] != NULL;
+                continue;
+            }
+            campo_t* campo = buscar_campo(hash, claves[base + i], largos[i], hashes[i], NULL);
+            resultados[base + i] = campo ? campo->dato : NULL;
+            encontradas += campo != NULL;
+        }
+    }
+    return encontradas;
+}
+
+/* hash_construir con pool hashea y copia las claves en paralelo, de a
+ * bloques del arreglo, y después las coloca con colocar_en_paralelo. */
+
+typedef struct construccion {
+    hash_t* hash;
+    const char** claves;
+    void** datos;
+    campo_t* campos;
+    size_t n;
+    size_t bloques;
+    bool sin_memoria;
+} construccion_t;
+
+static void preparar_bloque(void *extra, size_t bloque){
+    construccion_t* k = extra;
+    for (size_t i = k->n * bloque / k->bloques; i < k->n * (bloque + 1) / k->bloques; i++){
+        size_t largo = strlen(k->claves[i]);
+        campo_t* campo = &k->campos[i];
+        *campo = (campo_t) {
+            .hash = calcular_hash(k->hash, k->claves[i], largo),
+            .dato = k->datos[i],
+            .estado = OCUPADO,
+        };
+        // La arena no se puede usar desde varios hilos: sus copias van después
+        if (k->hash->arena) continue;
+        if (!copiar_clave(k->hash, campo, k->claves[i], largo)){
+            campo->estado = VACIO;
+            __atomic_store_n(&k->sin_memoria, true, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// Destruye el hash sin destruir ningún dato, que siguen siendo de quien
+// llamó a hash_construir.
+static hash_t *abortar_construccion(hash_t *hash){
+    hash->destruir_dato = NULL;
+    hash_destruir(hash);
+    return NULL;
+}
+
+hash_t *hash_construir(const hash_opciones_t *opciones, const char *claves[], void *datos[], size_t n){
+
+    hash_opciones_t con_lugar = *opciones;
+    if (con_lugar.capacidad < n) con_lugar.capacidad = n;
+    hash_t* hash = hash_crear_con_opciones(&con_lugar);
+    if (!hash) return NULL;
+
+    campo_t* campos = NULL;
+    if (hash->pool && pool_hilos(hash->pool) > 1 && n >= MINIMO_PARALELO && !hash->compacto) campos = malloc(n * sizeof(campo_t));
+    if (!campos) return hash_guardar_lote(hash, claves, datos, n) ? hash : abortar_construccion(hash);
+
+    construccion_t k = {
+        .hash = hash,
+        .claves = claves,
+        .datos = datos,
+        .campos = campos,
+        .n = n,
+        .bloques = pool_hilos(hash->pool) * REGIONES_POR_HILO,
+    };
+    pool_ejecutar(hash->pool, preparar_bloque, &k, k.bloques);
+    for (size_t i = 0; hash->arena && !k.sin_memoria && i < n; i++){
+        if (!copiar_clave(hash, &campos[i], claves[i], strlen(claves[i]))){
+            campos[i].estado = VACIO;
+            k.sin_memoria = true;
+        }
+    }
+
+    if (k.sin_memoria || !colocar_en_paralelo(hash, &hash->tabla, campos, n, true, &hash->cantidad)){
+        // Sin arena, las claves copiadas son de cada campo; con arena se
+        // liberan con el hash
+        for (size_t i = 0; !hash->arena && i < n; i++){
+            if (campos[i].estado == OCUPADO) liberar_clave(hash, &campos[i]);
+        }
+        free(campos);
+        return abortar_construccion(hash);
+    }
+
+    // Los campos reemplazados por una clave repetida más adelante
+    for (size_t i = 0; i < n; i++){
+        if (campos[i].estado == OCUPADO) continue;
+        if (hash->destruir_dato) hash->destruir_dato(campos[i].dato);
+        liberar_clave(hash, &campos[i]);
+    }
+    free(campos);
+    return hash;
+}
+
 /* ******************************************************************
- *                        ITERADOR HASH
+ *                        SNAPSHOTS
  * *****************************************************************/
 
-size_t buscar_primero(const hash_t* hash){
-	int pos=-1;
-	for (size_t i=0; i< hash->capacidad; i++){
-		if (hash->tabla[i]->estado == OCUPADO){
-			pos=(int)i;
-			break;
-		}
-	}
-	if (pos!=-1){
-		return (size_t)pos;
-	}
-    
-    return hash->capacidad;
-}
+#define MAGIA_SNAPSHOT "HASHSNP1"
+
+typedef struct dato_serializado{
+    const void* bytes;
+    size_t largo;
+}dato_serializado_t;
+
+/* Primero serializa los datos para conocer el largo de la imagen y después
+ * escribe el encabezado, las ranuras y el bloque en una sola pasada: la
+ * ranura de cada campo apunta a donde van a quedar su clave y su dato. */
+bool hash_guardar_snapshot(hash_t *hash, int fd, hash_serializar_dato_t serializar, void *extra){
+
+    if (hash->snapshot) return escribir_todo(fd, hash->snapshot, hash->snapshot->largo);
+    compactar(hash);
+    if (hash->vieja.capacidad) migrar(hash, SIZE_MAX);
+
+    // Las ranuras son las de una tabla de campos: con compacto se arma una
+    // temporal con las entradas vivas.
+    const tabla_t* t = &hash->tabla;
+    tabla_t temporal = {0};
+    if (hash->compacto){
+        if (!crear_tabla(&temporal, hash->tabla.capacidad, false)) return false;
+        for (size_t i = 0; i < hash->usadas; i++){
+            if (hash->entradas[i].estado == OCUPADO) insertar_campo(&temporal, hash->entradas[i]);
+        }
+        t = &temporal;
+    }
 
-hash_iter_t *hash_iter_crear(const hash_t *hash){
-    
-    hash_iter_t* iter = malloc(sizeof(hash_iter_t));
-    if(!iter) return NULL;
+    dato_serializado_t* datos = malloc((hash->cantidad + 1) * sizeof(dato_serializado_t));
+    escritor_t* escritor = escritor_crear(fd);
+    if (!datos || !escritor){
+        free(datos);
+        if (escritor) escritor_destruir(escritor);
+        destruir_tabla(&temporal);
+        return false;
+    }
 
-	iter->hash = hash;
-    iter->cant = 0;
-    iter->pos = buscar_primero(hash);
-    return iter;
+    size_t inicio_bloque = sizeof(snapshot_t) + t->capacidad * sizeof(ranura_t);
+    size_t largo = inicio_bloque;
+    for (size_t i = 0, j = 0; i < t->capacidad; i++){
+        if (t->campos[i].estado != OCUPADO) continue;
+        datos[j] = (dato_serializado_t) {NULL, 0};
+        if (serializar) datos[j].bytes = serializar(t->campos[i].dato, &datos[j].largo, extra);
+        largo += alinear(t->campos[i].largo + (size_t) 1) + alinear(datos[j].largo);
+        j++;
+    }
+
+    snapshot_t encabezado = {
+        .capacidad = t->capacidad,
+        .cantidad = hash->cantidad,
+        .semilla = hash->semilla,
+        .control = calcular_hash(hash, MAGIA_SNAPSHOT, sizeof(encabezado.magia)),
+        .largo = largo,
+    };
+    memcpy(encabezado.magia, MAGIA_SNAPSHOT, sizeof(encabezado.magia));
+    escritor_escribir(escritor, &encabezado, sizeof(encabezado));
+
+    bool ok = true;
+    size_t desplazamiento = inicio_bloque;
+    for (size_t i = 0, j = 0; i < t->capacidad; i++){
+        ranura_t ranura = {0};
+        const campo_t* campo = &t->campos[i];
+        if (campo->estado == OCUPADO){
+            ranura.hash = campo->hash;
+            ranura.largo = campo->largo;
+            ranura.largo_dato = (uint32_t) datos[j].largo;
+            ranura.clave = desplazamiento;
+            desplazamiento += alinear(campo->largo + (size_t) 1);
+            ranura.dato = desplazamiento;
+            desplazamiento += alinear(datos[j].largo);
+            ok &= datos[j].largo <= UINT32_MAX;
+            j++;
+        }
+        escritor_escribir(escritor, &ranura, sizeof(ranura));
+    }
+
+    for (size_t i = 0, j = 0; i < t->capacidad; i++){
+        if (t->campos[i].estado != OCUPADO) continue;
+        escritor_escribir_alineado(escritor, clave_de(&t->campos[i]), t->campos[i].largo + (size_t) 1);
+        escritor_escribir_alineado(escritor, datos[j].bytes, datos[j].largo);
+        j++;
+    }
+
+    ok &= escritor_destruir(escritor);
+    free(datos);
+    destruir_tabla(&temporal);
+    return ok;
 }
 
-const char *hash_iter_ver_actual(const hash_iter_t *iter){
-    if(hash_iter_al_final(iter)) return NULL;
-	if(iter->hash->tabla[(iter->pos)]->estado == OCUPADO) return iter->hash->tabla[(iter->pos)]->clave; 
-	return NULL;
-=======
-bool hash_pertenece(const hash_t *hash, const char *clave){	
-	size_t inicial= (size_t) fhash(clave);
-	
-	for (size_t i=0; i<hash->capacidad; i++){
-		size_t pos= (inicial + i)%hash->capacidad;
-		if (!hash->tabla[pos]) continue;
-		if (hash->tabla[pos]->estado==OCUPADO && strcmp(hash->tabla[pos]->clave,clave)==0){
-			return true;
-		}	
-	}
-	return false;
-}
-
-
-size_t hash_cantidad(const hash_t *hash){	
-	return hash->cantidad;
+// Comprueba que la imagen de largo bytes tenga un encabezado de snapshot
+// hecho con la función de hash dada y que cada ranura ocupada apunte a una
+// clave terminada en '\0' y a un dato dentro de la imagen.
+static bool snapshot_valido(const snapshot_t *snapshot, size_t largo, hash_funcion_t funcion_hash){
+    if (largo < sizeof(snapshot_t) || memcmp(snapshot->magia, MAGIA_SNAPSHOT, sizeof(snapshot->magia))) return false;
+    if (snapshot->largo != largo || !snapshot->capacidad || snapshot->capacidad & (snapshot->capacidad - 1)) return false;
+    if (snapshot->capacidad > (largo - sizeof(snapshot_t)) / sizeof(ranura_t)) return false;
+    if (funcion_hash(MAGIA_SNAPSHOT, sizeof(snapshot->magia), snapshot->semilla) != snapshot->control) return false;
+
+    const ranura_t* ranuras = ranuras_de(snapshot);
+    size_t inicio_bloque = sizeof(snapshot_t) + (size_t) snapshot->capacidad * sizeof(ranura_t);
+    size_t ocupadas = 0;
+    for (size_t i = 0; i < snapshot->capacidad; i++){
+        const ranura_t* ranura = &ranuras[i];
+        if (!ranura->clave) continue;
+        // Comparaciones de a una resta para que nada desborde
+        if (ranura->clave < inicio_bloque || ranura->clave >= largo) return false;
+        if (ranura->largo > largo - ranura->clave - 1) return false;
+        if (((const char*) snapshot)[ranura->clave + ranura->largo] != '\0') return false;
+        if (ranura->dato > largo || ranura->largo_dato > largo - ranura->dato) return false;
+        ocupadas++;
+    }
+    return ocupadas == snapshot->cantidad;
 }
 
+hash_t *hash_abrir_snapshot(const char *ruta, hash_funcion_t funcion_hash){
 
-//--------------------------BUSCADORES---------------------------------
+    int fd = open(ruta, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat estado;
+    void* imagen = MAP_FAILED;
+    if (fstat(fd, &estado) == 0 && (size_t) estado.st_size >= sizeof(snapshot_t)){
+        imagen = mmap(NULL, (size_t) estado.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    // La proyección sigue valiendo después de cerrar el archivo
+    close(fd);
+    if (imagen == MAP_FAILED) return NULL;
+
+    hash_t* hash = calloc(1, sizeof(hash_t));
+    if (!funcion_hash) funcion_hash = hash_funcion_rapida;
+    if (!hash || !snapshot_valido(imagen, (size_t) estado.st_size, funcion_hash)){
+        munmap(imagen, (size_t) estado.st_size);
+        free(hash);
+        return NULL;
+    }
 
-size_t buscar_primero(const hash_t* hash){
-	int pos=-1;
-	for (size_t i=0; i< hash->capacidad; i++){
-		if (hash->tabla[i] ){
-			pos=(int)i;
-			break;
-		}
-	}
-	if (pos!=-1){
-		return (size_t)pos;
-	}
-    
-    return hash->capacidad;
+    hash->snapshot = imagen;
+    hash->funcion_hash = funcion_hash;
+    hash->semilla = hash->snapshot->semilla;
+    hash->cantidad = hash->snapshot->cantidad;
+    hash->politica = hash_politica_por_defecto();
+    return hash;
 }
 
-size_t buscar_ultimo(const hash_t* hash){
-	int pos=-1;
-	size_t max=buscar_primero(hash);
-	for (size_t i=hash->capacidad-1; i>max; i--){
-		if (hash->tabla[i]){
-			pos=(int)i;
-			break;
-		}
-	}
-	if (pos!=-1){
-		return (size_t)pos;
-	}
-    
-    return (size_t)POS_INICIAL;
+/* ******************************************************************
+ *                        ITERADOR HASH
+ * *****************************************************************/
+
+/* El iterador recorre primero la tabla vieja, si hay una migración en curso,
+ * y después la actual: las posiciones de la actual van corridas en la
+ * capacidad de la vieja. Guarda el contador de modificaciones del hash: si
+ * cambió, algún campo pudo moverse y el iterador queda al final. */
+
+static size_t fin_iteracion(const hash_t* hash){
+    if (hash->snapshot) return hash->snapshot->capacidad;
+    if (hash->compacto) return hash->usadas;
+    return hash->vieja.capacidad + hash->tabla.capacidad;
 }
 
-//--------------------------ITERADOR---------------------------------
+static const campo_t* campo_en(const hash_t* hash, size_t pos){
+    if (hash->compacto) return &hash->entradas[pos];
+    if (pos < hash->vieja.capacidad) return &hash->vieja.campos[pos];
+    return &hash->tabla.campos[pos - hash->vieja.capacidad];
+}
 
+// Devuelve la primera posición ocupada de [pos, fin), o fin si no hay.
+static size_t buscar_siguiente(const hash_t* hash, size_t pos, size_t fin){
+    if (hash->snapshot){
+        const ranura_t* ranuras = ranuras_de(hash->snapshot);
+        while (pos < fin && !ranuras[pos].clave) pos++;
+        return pos;
+    }
+    if (hash->compacto){
+        while (pos < fin && hash->entradas[pos].estado != OCUPADO) pos++;
+        return pos;
+    }
+    size_t v = hash->vieja.capacidad;
+    if (pos < v){
+        size_t hasta = fin < v ? fin : v;
+        size_t sig = siguiente_ocupado(&hash->vieja, pos, hasta);
+        if (sig < hasta) return sig;
+        pos = v;
+    }
+    if (pos >= fin) return fin;
+    return v + siguiente_ocupado(&hash->tabla, pos - v, fin - v);
+}
 
 hash_iter_t *hash_iter_crear(const hash_t *hash){
-    
+    return hash_iter_crear_rango(hash, POS_INICIAL, fin_iteracion(hash));
+}
+
+hash_iter_t *hash_iter_crear_rango(const hash_t *hash, size_t inicio, size_t fin){
+
     hash_iter_t* iter = malloc(sizeof(hash_iter_t));
     if(!iter) return NULL;
 
-	iter->hash=hash;
-    if(!iter->hash) return NULL;
-    
-    //busca la primera posicion ocupada
-    iter->pos = buscar_primero(hash);
+    size_t posiciones = fin_iteracion(hash);
+    if (fin > posiciones) fin = posiciones;
+    if (inicio > fin) inicio = fin;
+	iter->hash = hash;
+    iter->fin = fin;
+    iter->pos = buscar_siguiente(hash, inicio, fin);
+    iter->modificaciones = hash->modificaciones;
+    iter->borro = false;
     return iter;
 }
 
+size_t hash_iter_posiciones(const hash_t *hash){
+    return fin_iteracion(hash);
+}
 
-bool hash_iter_al_final(const hash_iter_t *iter){
-    if( iter->pos == iter->hash->capacidad  ) return true;
-	//|| iter->pos==buscar_ultimo(iter->hash)
-	return false;
+const char *hash_iter_ver_actual(const hash_iter_t *iter){
+    if(hash_iter_al_final(iter)) return NULL;
+    if (iter->hash->snapshot) return hash_iter_ver_actual_bin(iter, NULL);
+	return clave_de(campo_en(iter->hash, iter->pos));
 }
 
+const void *hash_iter_ver_actual_bin(const hash_iter_t *iter, size_t *largo){
+    if(hash_iter_al_final(iter)) return NULL;
+    if (iter->hash->snapshot){
+        const ranura_t* ranura = &ranuras_de(iter->hash->snapshot)[iter->pos];
+        if (largo) *largo = ranura->largo;
+        return (const char*) iter->hash->snapshot + ranura->clave;
+    }
+    const campo_t* campo = campo_en(iter->hash, iter->pos);
+    if (largo) *largo = campo->largo;
+    return clave_de(campo);
+}
 
-bool hash_iter_avanzar(hash_iter_t *iter){
-	
-	if (hash_iter_al_final(iter) || !iter) return false;
-	//while(!iter->hash->tabla[iter->pos] && iter->hash->cantidad<=iter->pos){
-	
-	for(size_t i=iter->pos; i< iter->hash->capacidad;i++){
-		if (iter->hash->tabla[i] && iter->hash->tabla[i]->estado==OCUPADO){
-			 iter->pos=i;
-			return true;
-		}
-	}
-	return false;
-	
-			
+void *hash_iter_ver_dato(const hash_iter_t *iter){
+    if(hash_iter_al_final(iter)) return NULL;
+    if (iter->hash->snapshot){
+        return (char*) iter->hash->snapshot + ranuras_de(iter->hash->snapshot)[iter->pos].dato;
+    }
+    return campo_en(iter->hash, iter->pos)->dato;
 }
 
+void *hash_iter_borrar_actual(hash_iter_t *iter){
+    if(hash_iter_al_final(iter) || iter->hash->snapshot) return NULL;
 
-const char *hash_iter_ver_actual(const hash_iter_t *iter){
-	
-	if(iter->hash->tabla[(iter->pos)] && iter->hash->tabla[(iter->pos)]->estado==OCUPADO) return iter->hash->tabla[(iter->pos)]->clave; 
-	return NULL;
+    hash_t* hash = (hash_t*) iter->hash;
+    void* dato;
+    if (hash->compacto){
+        campo_t* entrada = &hash->entradas[iter->pos];
+        size_t pos = 0;
+        buscar_entrada(hash, clave_de(entrada), entrada->largo, entrada->hash, &pos);
+        dato = entrada->dato;
+        quitar_entrada(hash, entrada, pos);
+    } else {
+        bool en_vieja = iter->pos < hash->vieja.capacidad;
+        tabla_t* t = en_vieja ? &hash->vieja : &hash->tabla;
+        size_t pos = en_vieja ? iter->pos : iter->pos - hash->vieja.capacidad;
+        dato = t->campos[pos].dato;
+        t->ocupados[pos / BITS_POR_PALABRA] &= ~(UINT64_C(1) << (pos % BITS_POR_PALABRA));
+        hash->pendientes++;
+    }
+    hash->cantidad--;
+    // Otro iterador podría estar parado en el elemento borrado
+    iter->modificaciones = ++hash->modificaciones;
+    iter->borro = true;
+    iter->pos = buscar_siguiente(hash, iter->pos + 1, iter->fin);
+    return dato;
 }
 
+bool hash_iter_valido(const hash_iter_t *iter){
+    return iter->modificaciones == iter->hash->modificaciones;
+}
 
 void hash_iter_destruir(hash_iter_t* iter){
+    if (iter->borro) compactar((hash_t*) iter->hash);
 	free(iter);
 }
 
+bool hash_iter_avanzar(hash_iter_t *iter){
 
-//-------------------------REDIMENSION---------------------------------
+	if (hash_iter_al_final(iter)) return false;
 
+	iter->pos = buscar_siguiente(iter->hash, iter->pos + 1, iter->fin);
+	return !hash_iter_al_final(iter);
+}
 
-size_t factorial(size_t n){
-	size_t c,fact;
-	fact=1;
-	for (c = 1; c <= n; c++){
-		fact = fact * c;
-	}
-	return fact;		
+bool hash_iter_al_final(const hash_iter_t *iter){
+    return !hash_iter_valido(iter) || iter->pos == iter->fin;
 }
 
-size_t calcular_primo(hash_t* hash, int criterio){
-	size_t ant;
-	size_t actual=hash->capacidad;
+/* ******************************************************************
+ *                        CURSOR HASH
+ * *****************************************************************/
+
+/* El cursor recorre las mismas posiciones que el iterador; pos es la
+ * siguiente que hay que mirar. */
+
+// Completa la clave, el largo, el dato y el hash del elemento de la
+// posición ocupada pos.
+static void leer_elemento(const hash_t *hash, size_t pos, hash_cursor_t *cursor){
+    if (hash->snapshot){
+        const ranura_t* ranura = &ranuras_de(hash->snapshot)[pos];
+        cursor->clave = (const char*) hash->snapshot + ranura->clave;
+        cursor->largo = ranura->largo;
+        cursor->dato = (char*) hash->snapshot + ranura->dato;
+        cursor->hash = ranura->hash;
+        return;
+    }
+    const campo_t* campo = campo_en(hash, pos);
+    cursor->clave = clave_de(campo);
+    cursor->largo = campo->largo;
+    cursor->dato = campo->dato;
+    cursor->hash = campo->hash;
+}
 
-	if (criterio==ACHICAR){
-		if (actual==TAM_MIN) return actual;
-		size_t i=actual;
-		while(!ant){
-			if ((factorial(i-1) + 1)%i==0) ant=i;
-			i--;
-		}
-		return ant;
-	}
-	
-	size_t i=actual;
-	size_t prox=actual;
-	while(prox==actual){
-		if ((factorial(i-1) + 1)%i==0) prox=i;
-		i++;
-	}
-	return prox;
+void hash_cursor_iniciar(hash_cursor_t *cursor, const hash_t *hash){
+    cursor->origen = hash;
+    cursor->pos = POS_INICIAL;
+    cursor->clave = NULL;
 }
 
+bool hash_cursor_avanzar(hash_cursor_t *cursor){
 
-void destruir_tabla(hash_t* hash){
-	size_t i = 0;
-    while (i < hash->capacidad){
-        if (!hash->tabla[i]){
-			 i++;
-			 continue;
-		}	 
-        if(hash->destruir_dato){
-            hash->destruir_dato(hash->tabla[i]->dato);
-        }
-		free(hash->tabla[i]->clave);
-        free(hash->tabla[i]); 
-        i++;
+    const hash_t* hash = cursor->origen;
+    size_t fin = fin_iteracion(hash);
+    size_t pos = buscar_siguiente(hash, cursor->pos, fin);
+    if (pos == fin){
+        cursor->pos = pos;
+        cursor->clave = NULL;
+        cursor->dato = NULL;
+        return false;
     }
->>>>>>> 81a106131497f70590d10ae654a716fa9404a3b7
+    cursor->pos = pos + 1;
+    leer_elemento(hash, pos, cursor);
+    return true;
 }
 
-void hash_iter_destruir(hash_iter_t* iter){
-	free(iter);
-}
+/* ******************************************************************
+ *                        RECORRIDO PARALELO
+ * *****************************************************************/
 
-bool hash_iter_avanzar(hash_iter_t *iter){
-	
-	if (hash_iter_al_final(iter) || !iter) return false;
-    
-	iter->cant ++;
-	for(size_t i=iter->pos +1; i < iter->hash->capacidad;i++){
-		if (iter->hash->tabla[i]->estado==OCUPADO){
-			iter->pos=i;
-			return true;
-		}
-	}
-	return false;
-}
-
-<<<<<<< HEAD
-bool hash_iter_al_final(const hash_iter_t *iter){
-    return iter->cant == iter->hash->cantidad;
-}
-=======
-void redimensionar(hash_t *hash,int criterio){
-	
-	
-	hash_iter_t* iterador= hash_iter_crear(hash);
-	
-	hash_t* nuevo=hash_crear(hash->destruir_dato);
-	
-	size_t n=calcular_primo(hash,criterio);
-	nuevo->tabla=realloc(nuevo->tabla,n); 
-	
-	
-	while(!hash_iter_al_final(iterador)){
-		
-		const char *clave_vieja=hash_iter_ver_actual(iterador);
-		if (!clave_vieja) continue;
-		
-		size_t i=buscar_vacio(nuevo,clave_vieja);
-
-		if (nuevo->tabla[i])continue;
-		
-		nuevo->tabla[i]=calloc(1,sizeof(campo_t));
-		
-		if(!nuevo->tabla[i]) continue;
-		
-		nuevo->tabla[i]->clave=calloc(1,sizeof(char*));
-		if(!nuevo->tabla[i]->clave) continue;
-
-		strcpy(nuevo->tabla[i]->clave,clave_vieja);
-
-		nuevo->tabla[i]->dato=iterador->hash->tabla[(iterador->pos)]->dato;
-		
-		nuevo->cantidad++;	
-		hash_iter_avanzar(iterador);
-	}
-	destruir_tabla(hash);
-	hash->tabla=nuevo->tabla;
-	free(nuevo);
-	hash_iter_destruir(iterador);
-	
-
-}
-
-
-
-//-----------PRIMITIVAS DE HASH QUE DEPENDEN DE REDIMENSION-----------
+/* Las posiciones del iterador se parten en partes contiguas que empiezan en
+ * múltiplos de BITS_POR_PALABRA: cada hilo lee sus propias palabras de
+ * ocupados y un tramo propio de campos, sin compartir líneas de cache con
+ * los demás salvo en los bordes. */
 
-void *hash_borrar(hash_t *hash, const char *clave){
-	
-	if(!hash_pertenece(hash,clave)) return NULL;
-		
-	size_t i=buscar_ocupado(hash,clave);
-	if (!hash->tabla[i]) return NULL;
-	if (i==0 && hash->tabla[i]->estado!=OCUPADO && strcmp(hash->tabla[i]->clave,clave)!=0) return NULL;
-
-	void* dato;
-	if (hash->destruir_dato!=NULL){
-		dato=hash_obtener(hash,clave);
-		hash->destruir_dato(hash->tabla[i]->dato);
-	}
-	dato=hash->tabla[i]->dato;
-	hash->tabla[i]->estado= BORRADO;
-	//hash->tabla[i]->clave='\0';
-	hash->tabla[i]->clave=NULL;
-	hash->cantidad--;
-	hash->borrados++;
-	
-	float carga= (float)(hash->cantidad+ hash->borrados)/ (float) hash->capacidad;
-	if (carga >=0.7)	redimensionar(hash,AGRANDAR);
-
-	return dato;
+typedef struct recorrido {
+    const hash_t* hash;
+    hash_visitar_t visitar;
+    void* extra;
+    size_t posiciones;
+    size_t partes;
+} recorrido_t;
+
+// Devuelve la primera posición de la parte dada.
+static size_t inicio_parte(const recorrido_t *r, size_t parte){
+    size_t palabras = (r->posiciones + BITS_POR_PALABRA - 1) / BITS_POR_PALABRA;
+    size_t inicio = palabras * parte / r->partes * BITS_POR_PALABRA;
+    return inicio < r->posiciones ? inicio : r->posiciones;
 }
 
+static void recorrer_parte(void *extra, size_t parte){
+    const recorrido_t* r = extra;
+    size_t fin = inicio_parte(r, parte + 1);
+    hash_cursor_t cursor = { .origen = r->hash };
+    for (size_t pos = buscar_siguiente(r->hash, inicio_parte(r, parte), fin); pos < fin;
+         pos = buscar_siguiente(r->hash, pos + 1, fin)){
+        cursor.pos = pos + 1;
+        leer_elemento(r->hash, pos, &cursor);
+        r->visitar(&cursor, parte, r->extra);
+    }
+}
 
-bool hash_guardar(hash_t *hash, const char *clave, void *dato){
-	
-	size_t i;
-	if(hash_pertenece(hash,clave)){
-		i=buscar_ocupado(hash,clave);
-		if (!hash->tabla[i] || hash->tabla[i]->estado!=OCUPADO || strcmp(hash->tabla[i]->clave,clave)!=0) return false;
-		strcpy(hash->tabla[i]->clave,clave);
-
-		hash->tabla[i]->dato= dato;
-		hash->tabla[i]->estado= OCUPADO;	
-		
-		return true;
-	}
-	float carga= (float)(hash->cantidad+ hash->borrados)/ (float) hash->capacidad;
-	if (carga >=0.7)	redimensionar(hash,AGRANDAR);
-	
-	i=buscar_vacio(hash,clave);
-
-	if (hash->tabla[i]) return false;
-	
-    hash->tabla[i]=calloc(1,sizeof(campo_t));
-    
-    if(!hash->tabla[i]) return false;
-    
-    hash->tabla[i]->clave=calloc(1,sizeof(char*));
-    if(!hash->tabla[i]->clave) return false;
-	
-	strcpy(hash->tabla[i]->clave,clave);
-	
-	hash->tabla[i]->dato= dato;
-	hash->tabla[i]->estado= OCUPADO;	
-	hash->cantidad++;
-	
-	return true;
-}
-
-
->>>>>>> 81a106131497f70590d10ae654a716fa9404a3b7
+void hash_para_cada_paralelo(const hash_t *hash, pool_t *pool, size_t partes, hash_visitar_t visitar, void *extra){
+    if (!partes) return;
+
+    recorrido_t r = {
+        .hash = hash,
+        .visitar = visitar,
+        .extra = extra,
+        .posiciones = fin_iteracion(hash),
+        .partes = partes,
+    };
+    if (pool){
+        pool_ejecutar(pool, recorrer_parte, &r, partes);
+        return;
+    }
+    for (size_t parte = 0; parte < partes; parte++) recorrer_parte(&r, parte);
+}
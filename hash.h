@@ -1,8 +1,10 @@
 #ifndef HASH_H
 #define HASH_H
 
+#include "pool.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 // Los structs deben llamarse "hash" y "hash_iter".
 struct hash;
@@ -14,10 +16,114 @@ typedef struct hash_iter hash_iter_t;
 // tipo de función para destruir dato
 typedef void (*hash_destruir_dato_t)(void *);
 
+// tipo de función para hash_actualizar: recibe la clave, el dato actual (NULL
+// si la clave no estaba), si la clave estaba y el puntero extra, y devuelve el
+// dato a guardar
+typedef void *(*hash_actualizar_dato_t)(const char *clave, void *dato, bool existia, void *extra);
+
+// tipo de función de hash: recibe los bytes de la clave, su largo y una semilla
+typedef uint64_t (*hash_funcion_t)(const void *clave, size_t largo, uint64_t semilla);
+
+/* Función de hash de 64 bits incluida (familia wyhash), usada por defecto.
+ * Con distintas semillas da funciones de hash independientes.
+ */
+uint64_t hash_funcion_rapida(const void *clave, size_t largo, uint64_t semilla);
+
+/* Motor de búsqueda del hash.
+ * HASH_MOTOR_LINEAL: sondeo lineal Robin Hood, campo por campo.
+ * HASH_MOTOR_GRUPOS: además guarda un byte de control por campo y compara
+ * 16 o 32 campos por instrucción (SSE2/AVX2, elegido al crear el hash según
+ * el procesador). Conviene para cargas con muchas más búsquedas que
+ * modificaciones.
+ */
+typedef enum hash_motor {
+    HASH_MOTOR_LINEAL,
+    HASH_MOTOR_GRUPOS,
+} hash_motor_t;
+
+/* Política de redimensión del hash.
+ * - carga_maxima: la tabla se agranda al superar esta proporción de campos
+ *   ocupados (a lo sumo 0.95).
+ * - carga_minima: con reducir en true, la tabla se achica al bajar de esta
+ *   proporción.
+ * - factor_crecimiento: cuánto se multiplica la capacidad al agrandar, entre
+ *   2 y 64 (se redondea a potencia de dos).
+ * - histeresis: al achicar, la carga nueva tiene que quedar al menos esta
+ *   proporción por debajo de carga_maxima; si no, la tabla no se achica.
+ */
+typedef struct hash_politica {
+    double carga_maxima;
+    double carga_minima;
+    size_t factor_crecimiento;
+    bool reducir;
+    double histeresis;
+} hash_politica_t;
+
+/* Devuelve la política por defecto: carga entre 0.25 y 0.7, duplicar al
+ * agrandar, achicar con histéresis de 0.1.
+ */
+hash_politica_t hash_politica_por_defecto(void);
+
+/* Opciones de creación del hash. Los campos en cero toman el valor por
+ * defecto.
+ * Con arena_claves las copias de las claves salen de páginas propias del
+ * hash: no pagan el encabezado de malloc y hash_destruir las libera de a
+ * páginas en lugar de clave por clave.
+ * Con redimension_incremental, agrandar o achicar la tabla no mueve todos
+ * los elementos de una vez: la tabla vieja y la nueva conviven y cada
+ * hash_guardar o hash_borrar siguiente mueve una cantidad acotada de
+ * posiciones. Las búsquedas y el iterador consultan las dos tablas.
+ * Con pool, las redimensiones no incrementales de tablas grandes reparten
+ * la reubicación de los elementos entre los hilos del pool. El pool no es
+ * del hash: tiene que durar más que él y no lo pueden usar dos hashes a la
+ * vez.
+ * Con compacto, los elementos se guardan uno detrás de otro en orden de
+ * inserción y la tabla sólo tiene índices de 4 bytes a ese arreglo: el
+ * iterador los recorre en orden de inserción sin pasar por lugares vacíos
+ * y redimensionar sólo rearma los índices. Reemplazar el dato de una clave
+ * no cambia su lugar en el orden. No se puede combinar con
+ * HASH_MOTOR_GRUPOS ni con redimension_incremental, y guarda a lo sumo
+ * UINT32_MAX elementos.
+ */
+typedef struct hash_opciones {
+    hash_destruir_dato_t destruir_dato;
+    hash_funcion_t funcion_hash;    // NULL: hash_funcion_rapida
+    uint64_t semilla;
+    hash_motor_t motor;             // HASH_MOTOR_LINEAL
+    bool arena_claves;              // copia las claves en una arena propia
+    bool redimension_incremental;   // reparte cada redimensión entre operaciones
+    size_t capacidad;               // cantidad de elementos a guardar sin redimensionar
+    const hash_politica_t *politica; // NULL: hash_politica_por_defecto()
+    pool_t *pool;                   // NULL: todo en el hilo que llama
+    bool compacto;                  // elementos en orden de inserción e índices
+} hash_opciones_t;
+
 /* Crea el hash
  */
 hash_t *hash_crear(hash_destruir_dato_t destruir_dato);
 
+/* Crea el hash con lugar para guardar cantidad elementos sin redimensionar.
+ */
+hash_t *hash_crear_con_capacidad(hash_destruir_dato_t destruir_dato, size_t cantidad);
+
+/* Crea el hash con las opciones dadas. Devuelve NULL si no hay memoria, si
+ * la política no es válida o si las opciones no se pueden combinar.
+ * Pre: opciones no es NULL
+ */
+hash_t *hash_crear_con_opciones(const hash_opciones_t *opciones);
+
+/* Cambia la política de redimensión, que se aplica desde la próxima
+ * operación. Devuelve false, sin cambiar nada, si la política no es válida.
+ * Pre: La estructura hash fue inicializada
+ */
+bool hash_cambiar_politica(hash_t *hash, const hash_politica_t *politica);
+
+/* Agranda la tabla, si hace falta, para que entren cantidad elementos en
+ * total sin redimensionar. Devuelve false si no hay memoria.
+ * Pre: La estructura hash fue inicializada
+ */
+bool hash_reservar(hash_t *hash, size_t cantidad);
+
 /* Guarda un elemento en el hash, si la clave ya se encuentra en la
  * estructura, la reemplaza. De no poder guardarlo devuelve false.
  * Pre: La estructura hash fue inicializada
@@ -25,6 +131,43 @@ hash_t *hash_crear(hash_destruir_dato_t destruir_dato);
  */
 bool hash_guardar(hash_t *hash, const char *clave, void *dato);
 
+/* Guarda los n pares (claves[i], datos[i]) como si se llamara a
+ * hash_guardar con cada uno, en orden. Reserva lugar una sola vez, calcula
+ * los hashes de a tandas y adelanta la lectura de las posiciones a usar.
+ * Devuelve false si no pudo guardar todos; los guardados hasta ese momento
+ * quedan en el hash.
+ * Pre: La estructura hash fue inicializada
+ * Post: Se almacenaron los n pares
+ */
+bool hash_guardar_lote(hash_t *hash, const char *claves[], void *datos[], size_t n);
+
+/* Crea un hash con las opciones dadas y los n pares (claves[i], datos[i]),
+ * como si se llamara a hash_guardar con cada uno, en orden. Con un pool en
+ * las opciones, hashea, copia las claves y las ubica en la tabla repartiendo
+ * el trabajo entre sus hilos, que también pueden llamar a destruir_dato con
+ * los datos de claves repetidas. Devuelve NULL si no hay memoria; en ese
+ * caso no se destruye ningún dato.
+ * Pre: opciones no es NULL
+ */
+hash_t *hash_construir(const hash_opciones_t *opciones, const char *claves[], void *datos[], size_t n);
+
+/* Devuelve un puntero al lugar donde el hash guarda el dato de la clave. Si
+ * la clave no estaba, la agrega con dato NULL y pone insertado en true; si
+ * no, en false. Recorre la cadena de la clave una sola vez. El puntero deja
+ * de ser válido con la siguiente modificación del hash. Devuelve NULL si no
+ * hay memoria.
+ * Pre: La estructura hash fue inicializada
+ */
+void **hash_obtener_o_insertar(hash_t *hash, const char *clave, bool *insertado);
+
+/* Reemplaza el dato de la clave por el que devuelve actualizar, que recibe
+ * el dato actual, o NULL y existia en false si la clave no estaba (en ese
+ * caso la agrega). No se llama a destruir_dato con el dato anterior.
+ * Devuelve false si no hay memoria.
+ * Pre: La estructura hash fue inicializada
+ */
+bool hash_actualizar(hash_t *hash, const char *clave, hash_actualizar_dato_t actualizar, void *extra);
+
 /* Borra un elemento del hash y devuelve el dato asociado.  Devuelve
  * NULL si el dato no estaba.
  * Pre: La estructura hash fue inicializada
@@ -39,6 +182,15 @@ void *hash_borrar(hash_t *hash, const char *clave);
  */
 void *hash_obtener(const hash_t *hash, const char *clave);
 
+/* Deja en resultados[i] lo que devolvería hash_obtener(hash, claves[i]),
+ * para cada i de 0 a n - 1, y devuelve cuántas claves estaban. Como
+ * hash_guardar_lote, calcula los hashes de a tandas y pide por adelantado
+ * las posiciones de las claves que siguen, así las búsquedas en una tabla
+ * que no entra en cache esperan a la memoria a la vez y no de a una.
+ * Pre: La estructura hash fue inicializada
+ */
+size_t hash_obtener_lote(const hash_t *hash, const char *claves[], size_t n, void *resultados[]);
+
 /* Determina si clave pertenece o no al hash.
  * Pre: La estructura hash fue inicializada
  */
@@ -56,21 +208,164 @@ size_t hash_cantidad(const hash_t *hash);
  */
 void hash_destruir(hash_t *hash);
 
-/* Iterador del hash */
+/* Primitivas con hash precalculado */
+
+/* Devuelve el hash de la clave según la función y la semilla del hash. El
+ * valor sirve para las primitivas _h de cualquier hash creado con la misma
+ * función y semilla, así una clave que se busca en varios hashes se hashea
+ * una sola vez.
+ * Pre: La estructura hash fue inicializada
+ */
+uint64_t hash_calcular(const hash_t *hash, const char *clave);
+
+/* Versiones de las primitivas que reciben el hash de la clave en h en lugar
+ * de calcularlo. Se comportan igual que las primitivas sin _h.
+ * Pre: h es hash_calcular(hash, clave)
+ */
+bool hash_guardar_h(hash_t *hash, const char *clave, uint64_t h, void *dato);
+void *hash_borrar_h(hash_t *hash, const char *clave, uint64_t h);
+void *hash_obtener_h(const hash_t *hash, const char *clave, uint64_t h);
+bool hash_pertenece_h(const hash_t *hash, const char *clave, uint64_t h);
+void **hash_obtener_o_insertar_h(hash_t *hash, const char *clave, uint64_t h, bool *insertado);
+bool hash_actualizar_h(hash_t *hash, const char *clave, uint64_t h, hash_actualizar_dato_t actualizar, void *extra);
+
+/* Primitivas con claves binarias */
+
+/* Versiones de las primitivas para claves de largo bytes que pueden no
+ * terminar en '\0' y contener cualquier byte. Dos claves son iguales si
+ * tienen el mismo largo y los mismos bytes, así "ab" como cadena y los 2
+ * bytes "ab" son la misma clave. La clave que recibe actualizar y la que
+ * devuelve el iterador tienen un '\0' agregado después del último byte.
+ * Las que agregan claves fallan si largo no entra en 32 bits.
+ * Pre: La estructura hash fue inicializada
+ */
+uint64_t hash_calcular_bin(const hash_t *hash, const void *clave, size_t largo);
+bool hash_guardar_bin(hash_t *hash, const void *clave, size_t largo, void *dato);
+void *hash_borrar_bin(hash_t *hash, const void *clave, size_t largo);
+void *hash_obtener_bin(const hash_t *hash, const void *clave, size_t largo);
+bool hash_pertenece_bin(const hash_t *hash, const void *clave, size_t largo);
+void **hash_obtener_o_insertar_bin(hash_t *hash, const void *clave, size_t largo, bool *insertado);
+bool hash_actualizar_bin(hash_t *hash, const void *clave, size_t largo, hash_actualizar_dato_t actualizar, void *extra);
+
+/* Snapshots */
+
+// tipo de función para guardar datos en un snapshot: devuelve los bytes del
+// dato, que se copian al archivo, y guarda su cantidad en largo
+typedef const void *(*hash_serializar_dato_t)(void *dato, size_t *largo, void *extra);
+
+/* Escribe en fd, desde su posición actual, una imagen del hash que
+ * hash_abrir_snapshot puede usar sin reconstruirlo: la tabla con las
+ * posiciones de cada clave, y las claves y los datos en un bloque aparte,
+ * todo referido por desplazamientos desde el comienzo de la imagen. Cada
+ * dato se guarda con los bytes que devuelve serializar(dato, &largo, extra);
+ * con serializar NULL se guardan sólo las claves. Termina una migración
+ * pendiente. Devuelve false si falla alguna escritura o no hay memoria.
+ * La imagen sólo se puede abrir en una máquina con el mismo orden de bytes.
+ * Pre: La estructura hash fue inicializada
+ */
+bool hash_guardar_snapshot(hash_t *hash, int fd, hash_serializar_dato_t serializar, void *extra);
+
+/* Abre el snapshot guardado al comienzo del archivo ruta proyectándolo en
+ * memoria de sólo lectura: no lee ni copia las claves, así que abrir tarda
+ * lo mismo para cualquier tamaño y varios procesos que abren el mismo
+ * archivo comparten sus páginas. funcion_hash tiene que ser la misma con la
+ * que se creó el hash guardado (NULL: hash_funcion_rapida); la semilla se
+ * lee del archivo.
+ * El hash devuelto es de sólo lectura: hash_obtener devuelve un puntero a
+ * los bytes guardados del dato, que no se pueden modificar, las primitivas
+ * que modifican devuelven false o NULL sin cambiar nada y hash_destruir no
+ * llama a ninguna función destruir. Devuelve NULL si no se puede abrir el archivo
+ * o no es un snapshot hecho con funcion_hash.
+ */
+hash_t *hash_abrir_snapshot(const char *ruta, hash_funcion_t funcion_hash);
+
+/* Iterador del hash
+ * Si el hash se modifica por fuera del iterador (guardando una clave nueva,
+ * borrando o redimensionando), el iterador queda inválido: está al final y
+ * hash_iter_valido devuelve false. Reemplazar el dato de una clave que ya
+ * estaba no lo invalida. */
 
 // Crea iterador
 hash_iter_t *hash_iter_crear(const hash_t *hash);
 
+/* El iterador recorre las posiciones de 0 a hash_iter_posiciones(hash) - 1,
+ * salteando las vacías. Un iterador de rango sólo recorre las de
+ * [inicio, fin): con rangos que no se pisan, varios hilos pueden recorrer
+ * partes distintas del mismo hash a la vez si nadie lo modifica. */
+size_t hash_iter_posiciones(const hash_t *hash);
+hash_iter_t *hash_iter_crear_rango(const hash_t *hash, size_t inicio, size_t fin);
+
 // Avanza iterador
 bool hash_iter_avanzar(hash_iter_t *iter);
 
 // Devuelve clave actual, esa clave no se puede modificar ni liberar.
 const char *hash_iter_ver_actual(const hash_iter_t *iter);
 
+// Devuelve la clave actual y guarda su largo en largo, si no es NULL. Sirve
+// para recorrer claves binarias.
+const void *hash_iter_ver_actual_bin(const hash_iter_t *iter, size_t *largo);
+
+// Devuelve el dato de la clave actual, sin buscarla.
+void *hash_iter_ver_dato(const hash_iter_t *iter);
+
 // Comprueba si terminó la iteración
 bool hash_iter_al_final(const hash_iter_t *iter);
 
-// Destruye iterador
+// Devuelve false si el hash se modificó por fuera del iterador.
+bool hash_iter_valido(const hash_iter_t *iter);
+
+/* Borra el elemento actual y devuelve su dato, dejando el iterador en el
+ * siguiente. No redimensiona ni mueve a los demás elementos: la tabla se
+ * compacta al destruir el iterador o en la próxima modificación. Los otros
+ * iteradores del hash quedan inválidos. Devuelve NULL si el iterador está
+ * al final o el hash es un snapshot.
+ * Pre: el hash que se recorre se puede modificar
+ */
+void *hash_iter_borrar_actual(hash_iter_t *iter);
+
+// Destruye iterador. Si se borró con él, hay que destruirlo antes que el hash.
 void hash_iter_destruir(hash_iter_t* iter);
 
+/* Cursor del hash: recorre lo mismo que el iterador pero sin pedir memoria,
+ * así se puede declarar en la pila, y da juntos la clave, su largo, el dato
+ * y el hash guardado de cada elemento. Los campos pos y origen son internos.
+ * No se puede modificar el hash mientras se recorre.
+ *
+ *     hash_cursor_t cursor;
+ *     hash_cursor_iniciar(&cursor, hash);
+ *     while (hash_cursor_avanzar(&cursor)) usar(cursor.clave, cursor.dato);
+ */
+typedef struct hash_cursor {
+    const char *clave;
+    size_t largo;
+    void *dato;
+    uint64_t hash;
+    const hash_t *origen;
+    size_t pos;
+} hash_cursor_t;
+
+// Deja el cursor antes del primer elemento del hash.
+void hash_cursor_iniciar(hash_cursor_t *cursor, const hash_t *hash);
+
+// Pasa al elemento siguiente, o al primero si recién se inició, y completa
+// los campos del cursor. Devuelve false si no quedan elementos.
+bool hash_cursor_avanzar(hash_cursor_t *cursor);
+
+/* Recorrido paralelo */
+
+// tipo de función para visitar un elemento: recibe un cursor parado en él,
+// la parte del recorrido a la que pertenece y el puntero extra
+typedef void (*hash_visitar_t)(const hash_cursor_t *elemento, size_t parte, void *extra);
+
+/* Llama a visitar con cada elemento del hash, partiendo las posiciones en
+ * partes contiguas que se recorren como tareas de pool, o una detrás de otra
+ * en el hilo que llama si pool es NULL. Todos los elementos de una parte los
+ * visita el mismo hilo, en orden, así que visitar puede acumular en un
+ * resultado por parte sin sincronizar y después se combinan los resultados
+ * parciales. Conviene usar varias partes por hilo para repartir mejor.
+ * Pre: nadie modifica el hash durante el recorrido y nadie más ejecuta en
+ * el pool
+ */
+void hash_para_cada_paralelo(const hash_t *hash, pool_t *pool, size_t partes, hash_visitar_t visitar, void *extra);
+
 #endif // HASH_H
@@ -0,0 +1,427 @@
+#define _POSIX_C_SOURCE 200809L
+#include "hash_concurrente.h"
+#include "hash.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CAPACIDAD_INICIAL 16
+#define VALOR_AGRANDAR 0.7
+// Carga de la tabla nueva después de redimensionar
+#define CARGA_REDIMENSIONADA 0.35
+#define SEMILLA 0
+
+// Contadores de lectores por paridad de época: cada hilo usa uno según la
+// dirección de su pila, así los lectores no comparten línea de cache
+#define BITS_FRANJAS 4
+#define FRANJAS (1 << BITS_FRANJAS)
+// Locks de escritores, elegidos por los bits altos del hash de la clave
+#define BITS_CERROJOS 6
+#define CERROJOS (1 << BITS_CERROJOS)
+#define LINEA_CACHE 64
+// Cantidad de retiros que se juntan antes de esperar a los lectores
+#define RETIROS_POR_ESPERA 64
+
+/* ******************************************************************
+ *                        STRUCT HASH
+ * *****************************************************************/
+
+/* Cada clave vive en una entrada inmutable: reemplazar un dato publica una
+ * entrada nueva en el mismo campo. Las entradas que dejan de estar en la
+ * tabla se retiran y se liberan cuando ningún lector puede tenerlas. */
+typedef struct entrada {
+	uint64_t hash;
+	void* dato;
+	struct entrada* sig;    // en la lista de retiradas
+	bool destruir;          // al liberarla, destruir también el dato
+	size_t largo;
+	char clave[];
+} entrada_t;
+
+/* Sondeo lineal sobre punteros a entradas que se leen y escriben con
+ * operaciones atómicas. Un campo NULL está vacío y nunca vuelve a estarlo:
+ * borrar deja la marca BORRADA, que desaparece al redimensionar. */
+typedef struct tabla {
+	entrada_t** campos;
+	size_t capacidad;
+	struct tabla* sig;      // en la lista de retiradas
+} tabla_t;
+
+static entrada_t borrada;
+#define BORRADA (&borrada)
+
+typedef union contador {
+	size_t lectores;
+	char relleno[LINEA_CACHE];
+} contador_t;
+
+typedef union cerrojo {
+	pthread_mutex_t mutex;
+	char relleno[LINEA_CACHE];
+} cerrojo_t;
+
+/* Los lectores no toman locks: anotan su entrada en el contador de la
+ * paridad de la época actual. Para liberar algo ya despublicado, un escritor
+ * avanza la época y espera que los contadores de la paridad anterior lleguen
+ * a 0; los lectores que entren después ya no pueden ver lo despublicado.
+ *
+ * Los escritores toman redimension para lectura y el cerrojo de la franja de
+ * la clave, así dos escrituras de la misma clave no se cruzan; los campos
+ * vacíos se reclaman con compare-and-swap porque claves de franjas distintas
+ * comparten la tabla. Mientras sondean se anotan también como lectores,
+ * porque pasan por entradas de otras franjas que se pueden estar retirando.
+ * Redimensionar toma redimension para escritura. */
+struct hash_concurrente {
+	tabla_t* tabla;
+	pthread_rwlock_t redimension;
+	cerrojo_t* cerrojos;
+	contador_t* contadores;
+	size_t epoca;
+	size_t cantidad;
+	size_t usados;          // campos no vacíos, contando los BORRADA
+	pthread_mutex_t retiro;
+	entrada_t* entradas_retiradas;
+	tabla_t* tablas_retiradas;
+	size_t retiradas;
+	hash_concurrente_destruir_dato_t destruir_dato;
+};
+
+/* ******************************************************************
+ *                        LECTORES Y ÉPOCAS
+ * *****************************************************************/
+
+// Elige el contador del hilo a partir de una dirección de su pila.
+static size_t franja_propia(void){
+    int marca;
+    uint64_t pagina = (uint64_t) (uintptr_t) &marca >> 12;
+    return (size_t) ((pagina * 0x9e3779b97f4a7c15ULL) >> (64 - BITS_FRANJAS));
+}
+
+// Anota al lector y devuelve su contador, para salir.
+static size_t *entrar(const hash_concurrente_t *hash){
+    size_t franja = franja_propia();
+    while (true){
+        size_t epoca = __atomic_load_n(&hash->epoca, __ATOMIC_SEQ_CST);
+        size_t* contador = &hash->contadores[(epoca & 1) * FRANJAS + franja].lectores;
+        __atomic_add_fetch(contador, 1, __ATOMIC_SEQ_CST);
+        // Si la época cambió en el medio, el escritor pudo no verme
+        if (__atomic_load_n(&hash->epoca, __ATOMIC_SEQ_CST) == epoca) return contador;
+        __atomic_sub_fetch(contador, 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+static void salir(size_t *contador){
+    __atomic_sub_fetch(contador, 1, __ATOMIC_RELEASE);
+}
+
+// Espera a que terminen los lectores que pueden tener algo despublicado antes
+// de la llamada.
+// Pre: se tiene el lock retiro
+static void esperar_lectores(hash_concurrente_t *hash){
+    size_t epoca = __atomic_fetch_add(&hash->epoca, 1, __ATOMIC_SEQ_CST);
+    contador_t* anteriores = &hash->contadores[(epoca & 1) * FRANJAS];
+    for (size_t i = 0; i < FRANJAS; i++){
+        while (__atomic_load_n(&anteriores[i].lectores, __ATOMIC_ACQUIRE)) sched_yield();
+    }
+}
+
+static void liberar_entradas(hash_concurrente_t *hash, entrada_t *entrada){
+    while (entrada){
+        entrada_t* sig = entrada->sig;
+        if (entrada->destruir && hash->destruir_dato) hash->destruir_dato(entrada->dato);
+        free(entrada);
+        entrada = sig;
+    }
+}
+
+static void liberar_tablas(tabla_t *tabla){
+    while (tabla){
+        tabla_t* sig = tabla->sig;
+        free(tabla->campos);
+        free(tabla);
+        tabla = sig;
+    }
+}
+
+// Agrega una entrada o una tabla ya despublicada a las retiradas. Cada
+// RETIROS_POR_ESPERA, espera a los lectores y libera las acumuladas.
+static void retirar(hash_concurrente_t *hash, entrada_t *entrada, tabla_t *tabla){
+    pthread_mutex_lock(&hash->retiro);
+    if (entrada){
+        entrada->sig = hash->entradas_retiradas;
+        hash->entradas_retiradas = entrada;
+    }
+    if (tabla){
+        tabla->sig = hash->tablas_retiradas;
+        hash->tablas_retiradas = tabla;
+    }
+    entrada_t* entradas = NULL;
+    tabla_t* tablas = NULL;
+    if (++hash->retiradas >= RETIROS_POR_ESPERA){
+        entradas = hash->entradas_retiradas;
+        tablas = hash->tablas_retiradas;
+        hash->entradas_retiradas = NULL;
+        hash->tablas_retiradas = NULL;
+        hash->retiradas = 0;
+        esperar_lectores(hash);
+    }
+    pthread_mutex_unlock(&hash->retiro);
+
+    liberar_entradas(hash, entradas);
+    liberar_tablas(tablas);
+}
+
+/* ******************************************************************
+ *                        FUNCIONES AUXILIARES
+ * *****************************************************************/
+
+static entrada_t *crear_entrada(const char *clave, size_t largo, uint64_t h, void *dato){
+    entrada_t* entrada = malloc(sizeof(entrada_t) + largo + 1);
+    if (!entrada) return NULL;
+    entrada->hash = h;
+    entrada->dato = dato;
+    entrada->sig = NULL;
+    entrada->destruir = false;
+    entrada->largo = largo;
+    memcpy(entrada->clave, clave, largo + 1);
+    return entrada;
+}
+
+static tabla_t *crear_tabla(size_t capacidad){
+    tabla_t* tabla = malloc(sizeof(tabla_t));
+    if (!tabla) return NULL;
+    tabla->campos = calloc(capacidad, sizeof(entrada_t*));
+    if (!tabla->campos){
+        free(tabla);
+        return NULL;
+    }
+    tabla->capacidad = capacidad;
+    tabla->sig = NULL;
+    return tabla;
+}
+
+static inline bool coincide(const entrada_t *entrada, const char *clave, size_t largo, uint64_t h){
+    return entrada != BORRADA && entrada->hash == h && entrada->largo == largo
+        && memcmp(entrada->clave, clave, largo) == 0;
+}
+
+static inline entrada_t *leer_campo(const tabla_t *tabla, size_t pos){
+    return __atomic_load_n(&tabla->campos[pos], __ATOMIC_ACQUIRE);
+}
+
+// Devuelve la posición de la clave en la tabla, o la capacidad si no está.
+static size_t buscar(const tabla_t *tabla, const char *clave, size_t largo, uint64_t h){
+    size_t mascara = tabla->capacidad - 1;
+    for (size_t pos = (size_t) h & mascara; ; pos = (pos + 1) & mascara){
+        entrada_t* entrada = leer_campo(tabla, pos);
+        if (!entrada) return tabla->capacidad;
+        if (coincide(entrada, clave, largo, h)) return pos;
+    }
+}
+
+static size_t limite_usados(const tabla_t *tabla){
+    return (size_t) ((double) tabla->capacidad * VALOR_AGRANDAR);
+}
+
+// Pasa las entradas a una tabla nueva, sin marcas BORRADA, con lugar para
+// que la carga quede en CARGA_REDIMENSIONADA.
+static bool redimensionar(hash_concurrente_t *hash){
+    pthread_rwlock_wrlock(&hash->redimension);
+    tabla_t* vieja = hash->tabla;
+    // Otro escritor pudo haber redimensionado mientras esperaba
+    if (hash->usados < limite_usados(vieja)){
+        pthread_rwlock_unlock(&hash->redimension);
+        return true;
+    }
+
+    size_t capacidad = CAPACIDAD_INICIAL;
+    while ((double) (hash->cantidad + 1) / (double) capacidad > CARGA_REDIMENSIONADA) capacidad *= 2;
+    tabla_t* nueva = crear_tabla(capacidad);
+    if (!nueva){
+        pthread_rwlock_unlock(&hash->redimension);
+        return false;
+    }
+
+    for (size_t i = 0; i < vieja->capacidad; i++){
+        entrada_t* entrada = vieja->campos[i];
+        if (!entrada || entrada == BORRADA) continue;
+        size_t pos = (size_t) entrada->hash & (capacidad - 1);
+        while (nueva->campos[pos]) pos = (pos + 1) & (capacidad - 1);
+        nueva->campos[pos] = entrada;
+    }
+    __atomic_store_n(&hash->tabla, nueva, __ATOMIC_RELEASE);
+    hash->usados = hash->cantidad;
+    pthread_rwlock_unlock(&hash->redimension);
+
+    retirar(hash, NULL, vieja);
+    return true;
+}
+
+// Toma los locks de escritura de la clave con hash h y devuelve la tabla. Si
+// reservar, se asegura además un campo vacío para insertar.
+static tabla_t *empezar_escritura(hash_concurrente_t *hash, uint64_t h, bool reservar){
+    while (true){
+        pthread_rwlock_rdlock(&hash->redimension);
+        tabla_t* tabla = hash->tabla;
+        if (!reservar || __atomic_add_fetch(&hash->usados, 1, __ATOMIC_RELAXED) <= limite_usados(tabla)){
+            pthread_mutex_lock(&hash->cerrojos[h >> (64 - BITS_CERROJOS)].mutex);
+            return tabla;
+        }
+        __atomic_sub_fetch(&hash->usados, 1, __ATOMIC_RELAXED);
+        pthread_rwlock_unlock(&hash->redimension);
+        if (!redimensionar(hash)) return NULL;
+    }
+}
+
+static void terminar_escritura(hash_concurrente_t *hash, uint64_t h){
+    pthread_mutex_unlock(&hash->cerrojos[h >> (64 - BITS_CERROJOS)].mutex);
+    pthread_rwlock_unlock(&hash->redimension);
+}
+
+/* ******************************************************************
+ *                        PRIMITIVAS HASH
+ * *****************************************************************/
+
+hash_concurrente_t *hash_concurrente_crear(hash_concurrente_destruir_dato_t destruir_dato){
+
+    hash_concurrente_t* hash = calloc(1, sizeof(hash_concurrente_t));
+    if (!hash) return NULL;
+
+    void* cerrojos = NULL;
+    void* contadores = NULL;
+    hash->tabla = crear_tabla(CAPACIDAD_INICIAL);
+    if (!hash->tabla
+        || posix_memalign(&cerrojos, LINEA_CACHE, CERROJOS * sizeof(cerrojo_t))
+        || posix_memalign(&contadores, LINEA_CACHE, 2 * FRANJAS * sizeof(contador_t))){
+        liberar_tablas(hash->tabla);
+        free(cerrojos);
+        free(hash);
+        return NULL;
+    }
+    hash->cerrojos = cerrojos;
+    hash->contadores = memset(contadores, 0, 2 * FRANJAS * sizeof(contador_t));
+    for (size_t i = 0; i < CERROJOS; i++) pthread_mutex_init(&hash->cerrojos[i].mutex, NULL);
+    pthread_rwlock_init(&hash->redimension, NULL);
+    pthread_mutex_init(&hash->retiro, NULL);
+    hash->destruir_dato = destruir_dato;
+    return hash;
+}
+
+bool hash_concurrente_guardar(hash_concurrente_t *hash, const char *clave, void *dato){
+
+    size_t largo = strlen(clave);
+    uint64_t h = hash_funcion_rapida(clave, largo, SEMILLA);
+    entrada_t* nueva = crear_entrada(clave, largo, h, dato);
+    if (!nueva) return false;
+
+    tabla_t* tabla = empezar_escritura(hash, h, true);
+    if (!tabla){
+        free(nueva);
+        return false;
+    }
+
+    // El sondeo lee entradas de otras franjas, que se pueden retirar mientras
+    size_t* contador = entrar(hash);
+    entrada_t* anterior = NULL;
+    size_t mascara = tabla->capacidad - 1;
+    for (size_t pos = (size_t) h & mascara; ; pos = (pos + 1) & mascara){
+        entrada_t* entrada = leer_campo(tabla, pos);
+        if (!entrada){
+            // Otro escritor pudo tomar el campo: si pasa, lo vuelvo a mirar
+            if (__atomic_compare_exchange_n(&tabla->campos[pos], &entrada, nueva, false,
+                                            __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) break;
+        }
+        if (coincide(entrada, clave, largo, h)){
+            // Solo este escritor puede cambiar la entrada de esta clave
+            __atomic_store_n(&tabla->campos[pos], nueva, __ATOMIC_RELEASE);
+            anterior = entrada;
+            break;
+        }
+    }
+
+    // El campo reservado no se usó si la clave ya estaba
+    if (anterior) __atomic_sub_fetch(&hash->usados, 1, __ATOMIC_RELAXED);
+    else __atomic_add_fetch(&hash->cantidad, 1, __ATOMIC_RELAXED);
+    salir(contador);
+    terminar_escritura(hash, h);
+
+    if (anterior){
+        anterior->destruir = true;
+        retirar(hash, anterior, NULL);
+    }
+    return true;
+}
+
+void *hash_concurrente_borrar(hash_concurrente_t *hash, const char *clave){
+
+    size_t largo = strlen(clave);
+    uint64_t h = hash_funcion_rapida(clave, largo, SEMILLA);
+    tabla_t* tabla = empezar_escritura(hash, h, false);
+
+    size_t* contador = entrar(hash);
+    entrada_t* entrada = NULL;
+    size_t pos = buscar(tabla, clave, largo, h);
+    if (pos != tabla->capacidad){
+        entrada = leer_campo(tabla, pos);
+        __atomic_store_n(&tabla->campos[pos], BORRADA, __ATOMIC_RELEASE);
+        __atomic_sub_fetch(&hash->cantidad, 1, __ATOMIC_RELAXED);
+    }
+    salir(contador);
+    terminar_escritura(hash, h);
+
+    if (!entrada) return NULL;
+    void* dato = entrada->dato;
+    retirar(hash, entrada, NULL);
+    return dato;
+}
+
+void *hash_concurrente_obtener(const hash_concurrente_t *hash, const char *clave){
+
+    size_t largo = strlen(clave);
+    uint64_t h = hash_funcion_rapida(clave, largo, SEMILLA);
+
+    size_t* contador = entrar(hash);
+    const tabla_t* tabla = __atomic_load_n(&hash->tabla, __ATOMIC_ACQUIRE);
+    size_t pos = buscar(tabla, clave, largo, h);
+    void* dato = pos != tabla->capacidad ? leer_campo(tabla, pos)->dato : NULL;
+    salir(contador);
+    return dato;
+}
+
+bool hash_concurrente_pertenece(const hash_concurrente_t *hash, const char *clave){
+
+    size_t largo = strlen(clave);
+    uint64_t h = hash_funcion_rapida(clave, largo, SEMILLA);
+
+    size_t* contador = entrar(hash);
+    const tabla_t* tabla = __atomic_load_n(&hash->tabla, __ATOMIC_ACQUIRE);
+    bool pertenece = buscar(tabla, clave, largo, h) != tabla->capacidad;
+    salir(contador);
+    return pertenece;
+}
+
+size_t hash_concurrente_cantidad(const hash_concurrente_t *hash){
+    return __atomic_load_n(&hash->cantidad, __ATOMIC_RELAXED);
+}
+
+void hash_concurrente_destruir(hash_concurrente_t *hash){
+    for (size_t i = 0; i < hash->tabla->capacidad; i++){
+        entrada_t* entrada = hash->tabla->campos[i];
+        if (!entrada || entrada == BORRADA) continue;
+        entrada->destruir = true;
+        entrada->sig = NULL;
+        liberar_entradas(hash, entrada);
+    }
+    liberar_entradas(hash, hash->entradas_retiradas);
+    liberar_tablas(hash->tablas_retiradas);
+    liberar_tablas(hash->tabla);
+
+    for (size_t i = 0; i < CERROJOS; i++) pthread_mutex_destroy(&hash->cerrojos[i].mutex);
+    pthread_rwlock_destroy(&hash->redimension);
+    pthread_mutex_destroy(&hash->retiro);
+    free(hash->cerrojos);
+    free(hash->contadores);
+    free(hash);
+}
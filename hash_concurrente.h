@@ -0,0 +1,69 @@
+#ifndef HASH_CONCURRENTE_H
+#define HASH_CONCURRENTE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Hash para usar desde varios hilos a la vez, pensado para cargas con muchas
+ * más lecturas que escrituras. hash_concurrente_obtener y
+ * hash_concurrente_pertenece no toman ningún lock: nunca esperan a un
+ * escritor. Los escritores se sincronizan entre sí con un lock por franja de
+ * claves, así que escrituras de claves distintas avanzan en paralelo. Las
+ * tablas viejas, las claves borradas y los datos reemplazados se liberan
+ * recién cuando ningún lector puede estar usándolos. */
+struct hash_concurrente;
+
+typedef struct hash_concurrente hash_concurrente_t;
+
+// tipo de función para destruir dato
+typedef void (*hash_concurrente_destruir_dato_t)(void *);
+
+/* Crea el hash
+ */
+hash_concurrente_t *hash_concurrente_crear(hash_concurrente_destruir_dato_t destruir_dato);
+
+/* Guarda un elemento en el hash, si la clave ya se encuentra en la
+ * estructura, la reemplaza. El dato reemplazado se destruye cuando ningún
+ * lector puede tenerlo. De no poder guardarlo devuelve false.
+ * Pre: La estructura hash fue inicializada
+ * Post: Se almacenó el par (clave, dato)
+ */
+bool hash_concurrente_guardar(hash_concurrente_t *hash, const char *clave, void *dato);
+
+/* Borra un elemento del hash y devuelve el dato asociado.  Devuelve
+ * NULL si el dato no estaba. Otros hilos pueden seguir teniendo el dato
+ * devuelto por un hash_concurrente_obtener anterior.
+ * Pre: La estructura hash fue inicializada
+ * Post: El elemento fue borrado de la estructura y se lo devolvió,
+ * en el caso de que estuviera guardado.
+ */
+void *hash_concurrente_borrar(hash_concurrente_t *hash, const char *clave);
+
+/* Obtiene el valor de un elemento del hash, si la clave no se encuentra
+ * devuelve NULL. No toma locks. Si otro hilo reemplaza la clave, el dato
+ * devuelto se destruye con destruir_dato en algún momento posterior: con
+ * escritores concurrentes sobre la misma clave, quien llama tiene que
+ * coordinar el uso del dato por su cuenta.
+ * Pre: La estructura hash fue inicializada
+ */
+void *hash_concurrente_obtener(const hash_concurrente_t *hash, const char *clave);
+
+/* Determina si clave pertenece o no al hash. No toma locks.
+ * Pre: La estructura hash fue inicializada
+ */
+bool hash_concurrente_pertenece(const hash_concurrente_t *hash, const char *clave);
+
+/* Devuelve la cantidad de elementos del hash. Con escritores concurrentes es
+ * un valor aproximado.
+ * Pre: La estructura hash fue inicializada
+ */
+size_t hash_concurrente_cantidad(const hash_concurrente_t *hash);
+
+/* Destruye la estructura liberando la memoria pedida y llamando a la función
+ * destruir para cada dato. Ningún otro hilo puede estar usando el hash.
+ * Pre: La estructura hash fue inicializada
+ * Post: La estructura hash fue destruida
+ */
+void hash_concurrente_destruir(hash_concurrente_t *hash);
+
+#endif // HASH_CONCURRENTE_H
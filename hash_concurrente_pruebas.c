@@ -0,0 +1,264 @@
+/*
+ * hash_concurrente_pruebas.c
+ * Pruebas y mediciones para el hash concurrente
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include "hash_concurrente.h"
+#include "hash.h"
+#include "testing.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define LARGO_CLAVE 64
+
+/* ******************************************************************
+ *                        PRUEBAS UNITARIAS
+ * *****************************************************************/
+
+static void prueba_hash_concurrente_un_hilo(size_t largo)
+{
+    hash_concurrente_t* hash = hash_concurrente_crear(free);
+    print_test("Prueba hash concurrente crear", hash);
+    print_test("Prueba hash concurrente obtener en vacio es NULL", !hash_concurrente_obtener(hash, "A"));
+    print_test("Prueba hash concurrente borrar en vacio es NULL", !hash_concurrente_borrar(hash, "A"));
+
+    char clave[LARGO_CLAVE];
+    bool ok = true;
+    for (size_t i = 0; i < largo; i++){
+        size_t* valor = malloc(sizeof(size_t));
+        *valor = i;
+        sprintf(clave, "%08zu", i);
+        ok &= hash_concurrente_guardar(hash, clave, valor);
+    }
+    print_test("Prueba hash concurrente guardar muchos", ok && hash_concurrente_cantidad(hash) == largo);
+
+    /* Reemplazar destruye el dato anterior más tarde */
+    for (size_t i = 0; i < largo; i += 2){
+        size_t* valor = malloc(sizeof(size_t));
+        *valor = i + largo;
+        sprintf(clave, "%08zu", i);
+        ok &= hash_concurrente_guardar(hash, clave, valor);
+    }
+    print_test("Prueba hash concurrente reemplazar no cambia la cantidad", ok && hash_concurrente_cantidad(hash) == largo);
+
+    for (size_t i = 0; i < largo; i++){
+        sprintf(clave, "%08zu", i);
+        size_t* valor = hash_concurrente_obtener(hash, clave);
+        ok &= valor && *valor == (i % 2 ? i : i + largo);
+    }
+    print_test("Prueba hash concurrente obtener los valores nuevos", ok);
+
+    for (size_t i = 1; i < largo; i += 2){
+        sprintf(clave, "%08zu", i);
+        size_t* valor = hash_concurrente_borrar(hash, clave);
+        ok &= valor && *valor == i && !hash_concurrente_pertenece(hash, clave);
+        free(valor);
+    }
+    print_test("Prueba hash concurrente borrar la mitad", ok && hash_concurrente_cantidad(hash) == (largo + 1) / 2);
+
+    /* Volver a guardar claves borradas */
+    for (size_t i = 1; i < largo; i += 2){
+        sprintf(clave, "%08zu", i);
+        ok &= hash_concurrente_guardar(hash, clave, malloc(sizeof(size_t)));
+    }
+    print_test("Prueba hash concurrente volver a guardar", ok && hash_concurrente_cantidad(hash) == largo);
+
+    hash_concurrente_destruir(hash);
+}
+
+/* Estrés: los lectores buscan claves estables que nunca faltan y deben ver
+ * siempre su dato; los escritores reemplazan esas claves por el mismo dato y
+ * guardan y borran claves propias, lo que fuerza redimensiones y retiros
+ * mientras se lee. */
+
+typedef struct estres {
+    hash_concurrente_t* hash;
+    size_t estables;
+    size_t* valores;
+    size_t operaciones;
+    size_t id;
+    size_t errores;
+} estres_t;
+
+static void *leer_estables(void *arg)
+{
+    estres_t* estres = arg;
+    char clave[LARGO_CLAVE];
+    for (size_t n = 0; n < estres->operaciones; n++){
+        size_t i = (n * 7919 + estres->id) % estres->estables;
+        sprintf(clave, "estable:%zu", i);
+        if (hash_concurrente_obtener(estres->hash, clave) != &estres->valores[i]) estres->errores++;
+    }
+    return NULL;
+}
+
+static void *escribir(void *arg)
+{
+    estres_t* estres = arg;
+    char clave[LARGO_CLAVE];
+    for (size_t n = 0; n < estres->operaciones; n++){
+        sprintf(clave, "estable:%zu", n % estres->estables);
+        if (!hash_concurrente_guardar(estres->hash, clave, &estres->valores[n % estres->estables])) estres->errores++;
+
+        sprintf(clave, "propia:%zu:%zu", estres->id, n % 512);
+        if (n % 1024 < 512){
+            if (!hash_concurrente_guardar(estres->hash, clave, &estres->valores[0])) estres->errores++;
+        } else if (hash_concurrente_borrar(estres->hash, clave) != &estres->valores[0]){
+            estres->errores++;
+        }
+    }
+    return NULL;
+}
+
+static void prueba_hash_concurrente_estres(size_t lectores, size_t escritores, size_t operaciones)
+{
+    const size_t estables = 1000;
+    hash_concurrente_t* hash = hash_concurrente_crear(NULL);
+    size_t* valores = malloc(estables * sizeof(size_t));
+
+    char clave[LARGO_CLAVE];
+    for (size_t i = 0; i < estables; i++){
+        sprintf(clave, "estable:%zu", i);
+        hash_concurrente_guardar(hash, clave, &valores[i]);
+    }
+
+    size_t hilos = lectores + escritores;
+    pthread_t* ids = malloc(hilos * sizeof(pthread_t));
+    estres_t* estres = malloc(hilos * sizeof(estres_t));
+    for (size_t i = 0; i < hilos; i++){
+        estres[i] = (estres_t) {hash, estables, valores, operaciones, i, 0};
+        pthread_create(&ids[i], NULL, i < lectores ? leer_estables : escribir, &estres[i]);
+    }
+    size_t errores = 0;
+    for (size_t i = 0; i < hilos; i++){
+        pthread_join(ids[i], NULL);
+        errores += estres[i].errores;
+    }
+
+    print_test("Prueba hash concurrente estres sin errores", errores == 0);
+    /* operaciones es múltiplo de 1024: cada escritor termina con sus claves
+     * propias borradas */
+    print_test("Prueba hash concurrente estres cantidad final", hash_concurrente_cantidad(hash) == estables);
+
+    free(estres);
+    free(ids);
+    free(valores);
+    hash_concurrente_destruir(hash);
+}
+
+/* ******************************************************************
+ *                        RENDIMIENTO
+ * *****************************************************************/
+
+/* Compara búsquedas por segundo contra un hash_t protegido por un mutex
+ * global, con una escritura cada ESCRITURAS_CADA operaciones. */
+
+#define ESCRITURAS_CADA 100
+
+typedef struct medicion {
+    hash_concurrente_t* concurrente;
+    hash_t* hash;
+    pthread_mutex_t* mutex;
+    char (*claves)[LARGO_CLAVE];
+    size_t largo;
+    size_t operaciones;
+    size_t id;
+} medicion_t;
+
+static void *medir_concurrente(void *arg)
+{
+    medicion_t* m = arg;
+    for (size_t n = 0; n < m->operaciones; n++){
+        size_t i = (n * 7919 + m->id * 104729) % m->largo;
+        if (n % ESCRITURAS_CADA == 0) hash_concurrente_guardar(m->concurrente, m->claves[i], m->claves[i]);
+        else hash_concurrente_obtener(m->concurrente, m->claves[i]);
+    }
+    return NULL;
+}
+
+static void *medir_con_mutex(void *arg)
+{
+    medicion_t* m = arg;
+    for (size_t n = 0; n < m->operaciones; n++){
+        size_t i = (n * 7919 + m->id * 104729) % m->largo;
+        pthread_mutex_lock(m->mutex);
+        if (n % ESCRITURAS_CADA == 0) hash_guardar(m->hash, m->claves[i], m->claves[i]);
+        else hash_obtener(m->hash, m->claves[i]);
+        pthread_mutex_unlock(m->mutex);
+    }
+    return NULL;
+}
+
+// Devuelve millones de operaciones por segundo con hilos hilos.
+static double medir(void *(*funcion)(void *), medicion_t base, size_t hilos)
+{
+    pthread_t* ids = malloc(hilos * sizeof(pthread_t));
+    medicion_t* mediciones = malloc(hilos * sizeof(medicion_t));
+
+    struct timespec inicio, fin;
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    for (size_t i = 0; i < hilos; i++){
+        mediciones[i] = base;
+        mediciones[i].operaciones = base.operaciones / hilos;
+        mediciones[i].id = i;
+        pthread_create(&ids[i], NULL, funcion, &mediciones[i]);
+    }
+    for (size_t i = 0; i < hilos; i++) pthread_join(ids[i], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &fin);
+
+    free(mediciones);
+    free(ids);
+    double segundos = (double) (fin.tv_sec - inicio.tv_sec) + (double) (fin.tv_nsec - inicio.tv_nsec) / 1e9;
+    return (double) base.operaciones / segundos / 1e6;
+}
+
+static void prueba_hash_concurrente_rendimiento(size_t largo)
+{
+    medicion_t base = {
+        .concurrente = hash_concurrente_crear(NULL),
+        .hash = hash_crear(NULL),
+        .mutex = malloc(sizeof(pthread_mutex_t)),
+        .claves = malloc(largo * LARGO_CLAVE),
+        .largo = largo,
+        .operaciones = largo * 10,
+    };
+    pthread_mutex_init(base.mutex, NULL);
+    for (size_t i = 0; i < largo; i++){
+        sprintf(base.claves[i], "%08zu", i);
+        hash_concurrente_guardar(base.concurrente, base.claves[i], base.claves[i]);
+        hash_guardar(base.hash, base.claves[i], base.claves[i]);
+    }
+
+    printf("hilos - concurrente Mops/s - hash_t con mutex Mops/s\n");
+    for (size_t hilos = 1; hilos <= 64; hilos *= 2){
+        double concurrente = medir(medir_concurrente, base, hilos);
+        double con_mutex = medir(medir_con_mutex, base, hilos);
+        printf("%5zu - %8.2f - %8.2f\n", hilos, concurrente, con_mutex);
+    }
+
+    pthread_mutex_destroy(base.mutex);
+    free(base.mutex);
+    free(base.claves);
+    hash_destruir(base.hash);
+    hash_concurrente_destruir(base.concurrente);
+}
+
+/* ******************************************************************
+ *                        FUNCIÓN PRINCIPAL
+ * *****************************************************************/
+
+
+void pruebas_hash_concurrente(void)
+{
+    prueba_hash_concurrente_un_hilo(5000);
+    prueba_hash_concurrente_estres(4, 4, 20480);
+}
+
+void pruebas_volumen_concurrente(size_t largo)
+{
+    prueba_hash_concurrente_rendimiento(largo);
+}
@@ -0,0 +1,488 @@
+#define _POSIX_C_SOURCE 200809L
+#include "hash_congelado.h"
+#include "escritor.h"
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define MAGIA_CONGELADO "HASHCNG1"
+#define CLAVES_POR_BALDE 4
+#define MAX_INTENTOS 16
+#define LARGO_CLAVE_INTERNA 15
+
+/* ******************************************************************
+ *                        STRUCT HASH
+ * *****************************************************************/
+
+/* Función de hash perfecta mínima al estilo PTHash: cada clave cae en un
+ * balde según su hash y cada balde tiene un piloto de 16 bits que, mezclado
+ * con el hash de la clave, da su posición en una tabla de capacidad = n/0.99.
+ * Los pilotos se eligen al congelar, balde por balde de mayor a menor, para
+ * que ninguna posición se repita. Las posiciones de n en adelante se
+ * traducen con el arreglo libres a las posiciones menores que n que quedaron
+ * sin usar, así las n entradas quedan juntas.
+ *
+ * Todo el hash es una sola imagen: el encabezado, los pilotos, libres, las
+ * entradas y las claves, referidas por desplazamientos desde el comienzo.
+ * Las claves de hasta LARGO_CLAVE_INTERNA bytes van dentro de su entrada, así
+ * buscarlas lee sólo el piloto y la entrada; las demás, aparte. Todas
+ * terminan en '\0'. En memoria el dato de cada entrada es el puntero; en un
+ * archivo es el desplazamiento de sus bytes, que van al final. */
+typedef struct cabecera{
+    char magia[8];
+    uint64_t cantidad;
+    uint64_t capacidad;
+    uint64_t baldes;
+    uint64_t semilla;
+    uint64_t pilotos;
+    uint64_t libres;
+    uint64_t entradas;
+    uint64_t claves;
+    uint64_t largo;
+}cabecera_t;
+
+typedef struct entrada{
+    uint64_t dato;
+    uint32_t largo;
+    uint32_t largo_dato;
+    union {
+        uint64_t desplazamiento;
+        char interna[LARGO_CLAVE_INTERNA + 1];
+    } clave;
+}entrada_t;
+
+struct hash_congelado{
+    cabecera_t* imagen;
+    bool proyectado; // la imagen es un archivo abierto con hash_congelado_abrir
+};
+
+struct hash_congelado_iter{
+    const hash_congelado_t* hash;
+    size_t pos;
+};
+
+// Clave del hash original, mientras se congela.
+typedef struct origen{
+    const void* clave;
+    size_t largo;
+    void* dato;
+}origen_t;
+
+/* ******************************************************************
+ *                        FUNCIONES AUXILIARES
+ * *****************************************************************/
+
+static inline const uint16_t *pilotos_de(const cabecera_t *imagen){
+    return (const uint16_t*) ((const char*) imagen + imagen->pilotos);
+}
+
+static inline const uint64_t *libres_de(const cabecera_t *imagen){
+    return (const uint64_t*) ((const char*) imagen + imagen->libres);
+}
+
+static inline const entrada_t *entradas_de(const cabecera_t *imagen){
+    return (const entrada_t*) ((const char*) imagen + imagen->entradas);
+}
+
+static inline const char *clave_de(const cabecera_t *imagen, const entrada_t *entrada){
+    if (entrada->largo <= LARGO_CLAVE_INTERNA) return entrada->clave.interna;
+    return (const char*) imagen + entrada->clave.desplazamiento;
+}
+
+// Lo que ocupa la clave de largo bytes fuera de su entrada.
+static inline size_t largo_externo(size_t largo){
+    return largo <= LARGO_CLAVE_INTERNA ? 0 : alinear(largo + 1);
+}
+
+// Mezcla final de MurmurHash3: cada bit de x cambia la mitad de los de salida.
+static inline uint64_t mezclar(uint64_t x){
+    x ^= x >> 33;
+    x *= UINT64_C(0xff51afd7ed558ccd);
+    x ^= x >> 33;
+    x *= UINT64_C(0xc4ceb9fe1a85ec53);
+    return x ^ (x >> 33);
+}
+
+// Lleva x a [0, n) con los bits altos de x * n, que es más barato que el
+// resto de una división.
+static inline size_t reducir(uint64_t x, size_t n){
+#ifdef __SIZEOF_INT128__
+    __extension__ typedef unsigned __int128 uint128_t;
+    return (size_t) (((uint128_t) x * n) >> 64);
+#else
+    return (size_t) (x % n);
+#endif
+}
+
+// Como en PTHash, el 60% de las claves va al 30% de los baldes: los baldes
+// grandes se ubican primero, con la tabla vacía, y al final quedan muchos
+// baldes chicos, que encuentran piloto enseguida.
+static inline size_t balde_de(uint64_t h, size_t baldes){
+    size_t densos = baldes * 3 / 10;
+    if ((uint32_t) h < UINT32_C(0x9999999a)) return reducir(h, densos);
+    return densos + reducir(h, baldes - densos);
+}
+
+// Posición en la tabla de la clave con hash h si su balde tiene el piloto.
+static inline size_t posicion_con(uint64_t h, uint16_t piloto, size_t capacidad){
+    return reducir(mezclar(h ^ (piloto * UINT64_C(0x9e3779b97f4a7c15))), capacidad);
+}
+
+// Devuelve la entrada donde estaría la clave con hash h.
+static inline const entrada_t *entrada_de(const cabecera_t *imagen, uint64_t h){
+    size_t cantidad = (size_t) imagen->cantidad;
+    size_t balde = balde_de(h, (size_t) imagen->baldes);
+    size_t pos = posicion_con(h, pilotos_de(imagen)[balde], (size_t) imagen->capacidad);
+    if (pos >= cantidad) pos = (size_t) libres_de(imagen)[pos - cantidad];
+    return &entradas_de(imagen)[pos];
+}
+
+/* Busca un piloto para cada balde, de los más grandes a los más chicos,
+ * marcando en ocupado las posiciones que toman. Devuelve false si algún
+ * balde no tiene piloto posible, lo que pasa si dos claves tienen el mismo
+ * hash o, muy rara vez, por mala suerte con la semilla. */
+static bool elegir_pilotos(const uint64_t *hashes, size_t n, size_t baldes, size_t capacidad, uint16_t *pilotos, uint8_t *ocupado){
+
+    size_t* inicio = calloc(baldes + 1, sizeof(size_t));
+    size_t* miembros = malloc((n + 1) * sizeof(size_t));
+    size_t* orden = malloc(baldes * sizeof(size_t));
+    size_t* posiciones = NULL;
+    bool ok = inicio && miembros && orden;
+
+    // Agrupo las claves por balde con un conteo: el balde b queda entre
+    // inicio[b] e inicio[b + 1]
+    size_t mayor = 0;
+    for (size_t i = 0; ok && i < n; i++) inicio[balde_de(hashes[i], baldes)]++;
+    for (size_t b = 0; ok && b < baldes; b++){
+        if (inicio[b] > mayor) mayor = inicio[b];
+        if (b) inicio[b] += inicio[b - 1];
+    }
+    for (size_t i = 0; ok && i < n; i++) miembros[--inicio[balde_de(hashes[i], baldes)]] = i;
+    if (ok) inicio[baldes] = n;
+
+    // Y los baldes por tamaño, de mayor a menor, con otro
+    size_t* por_tamanio = ok ? calloc(mayor + 2, sizeof(size_t)) : NULL;
+    posiciones = malloc((mayor + 1) * sizeof(size_t));
+    ok &= por_tamanio && posiciones;
+    for (size_t b = 0; ok && b < baldes; b++) por_tamanio[mayor - (inicio[b + 1] - inicio[b]) + 1]++;
+    for (size_t t = 0; ok && t <= mayor; t++) por_tamanio[t + 1] += por_tamanio[t];
+    for (size_t b = 0; ok && b < baldes; b++) orden[por_tamanio[mayor - (inicio[b + 1] - inicio[b])]++] = b;
+    free(por_tamanio);
+
+    memset(ocupado, 0, capacidad);
+    memset(pilotos, 0, baldes * sizeof(uint16_t));
+    for (size_t k = 0; ok && k < baldes; k++){
+        size_t b = orden[k];
+        size_t tamanio = inicio[b + 1] - inicio[b];
+        if (!tamanio) break;
+
+        bool ubicado = false;
+        for (uint32_t piloto = 0; !ubicado && piloto <= UINT16_MAX; piloto++){
+            ubicado = true;
+            for (size_t j = 0; ubicado && j < tamanio; j++){
+                size_t pos = posicion_con(hashes[miembros[inicio[b] + j]], (uint16_t) piloto, capacidad);
+                ubicado = !ocupado[pos];
+                for (size_t i = 0; ubicado && i < j; i++) ubicado = posiciones[i] != pos;
+                posiciones[j] = pos;
+            }
+            if (ubicado) pilotos[b] = (uint16_t) piloto;
+        }
+        for (size_t j = 0; ubicado && j < tamanio; j++) ocupado[posiciones[j]] = 1;
+        ok = ubicado;
+    }
+
+    free(posiciones);
+    free(orden);
+    free(miembros);
+    free(inicio);
+    return ok;
+}
+
+// Junta las claves y los datos del hash. Devuelve NULL si no hay memoria.
+static origen_t *juntar_claves(const hash_t *hash, size_t n){
+
+    origen_t* origen = malloc((n + 1) * sizeof(origen_t));
+    if (!origen) return NULL;
+    hash_cursor_t cursor;
+    hash_cursor_iniciar(&cursor, hash);
+    for (size_t i = 0; i < n && hash_cursor_avanzar(&cursor); i++){
+        origen[i] = (origen_t) {cursor.clave, cursor.largo, cursor.dato};
+    }
+    return origen;
+}
+
+/* Con los pilotos elegidos, completa libres con las posiciones menores que
+ * la cantidad que quedaron sin ocupar, y ubica cada clave en su entrada. */
+static void completar_imagen(cabecera_t *imagen, const origen_t *origen, const uint64_t *hashes, const uint8_t *ocupado){
+
+    size_t n = (size_t) imagen->cantidad;
+    uint64_t* libres = (uint64_t*) ((char*) imagen + imagen->libres);
+    size_t libre = 0;
+    for (size_t pos = n; pos < imagen->capacidad; pos++){
+        libres[pos - n] = 0;
+        if (!ocupado[pos]) continue;
+        while (ocupado[libre]) libre++;
+        libres[pos - n] = libre++;
+    }
+
+    size_t desplazamiento = (size_t) imagen->claves;
+    for (size_t i = 0; i < n; i++){
+        entrada_t* entrada = (entrada_t*) entrada_de(imagen, hashes[i]);
+        entrada->dato = (uintptr_t) origen[i].dato;
+        entrada->largo = (uint32_t) origen[i].largo;
+        entrada->largo_dato = 0;
+
+        char* clave = entrada->clave.interna;
+        if (origen[i].largo > LARGO_CLAVE_INTERNA){
+            clave = (char*) imagen + desplazamiento;
+            entrada->clave.desplazamiento = desplazamiento;
+            desplazamiento += largo_externo(origen[i].largo);
+        }
+        memcpy(clave, origen[i].clave, origen[i].largo);
+    }
+}
+
+/* ******************************************************************
+ *                        PRIMITIVAS HASH
+ * *****************************************************************/
+
+hash_congelado_t *hash_congelar(const hash_t *hash){
+
+    size_t n = hash_cantidad(hash);
+    hash_congelado_t* congelado = malloc(sizeof(hash_congelado_t));
+    origen_t* origen = juntar_claves(hash, n);
+    uint64_t* hashes = malloc((n + 1) * sizeof(uint64_t));
+
+    cabecera_t cabecera = {
+        .cantidad = n,
+        .capacidad = n + n / 100 + 1,
+        .baldes = n / CLAVES_POR_BALDE + 4,
+    };
+    memcpy(cabecera.magia, MAGIA_CONGELADO, sizeof(cabecera.magia));
+    cabecera.pilotos = sizeof(cabecera_t);
+    cabecera.libres = alinear(cabecera.pilotos + cabecera.baldes * sizeof(uint16_t));
+    cabecera.entradas = cabecera.libres + (cabecera.capacidad - n) * sizeof(uint64_t);
+    cabecera.claves = cabecera.entradas + n * sizeof(entrada_t);
+    cabecera.largo = cabecera.claves;
+    for (size_t i = 0; origen && i < n; i++) cabecera.largo += largo_externo(origen[i].largo);
+
+    cabecera_t* imagen = calloc(1, (size_t) cabecera.largo);
+    uint8_t* ocupado = malloc((size_t) cabecera.capacidad);
+    bool ok = congelado && origen && hashes && imagen && ocupado;
+    if (ok) *imagen = cabecera;
+
+    // Con otra semilla cambian todas las posiciones
+    bool ubicado = false;
+    for (uint64_t intento = 0; ok && !ubicado && intento < MAX_INTENTOS; intento++){
+        imagen->semilla = intento;
+        for (size_t i = 0; i < n; i++) hashes[i] = hash_funcion_rapida(origen[i].clave, origen[i].largo, intento);
+        ubicado = elegir_pilotos(hashes, n, (size_t) cabecera.baldes, (size_t) cabecera.capacidad,
+                                 (uint16_t*) ((char*) imagen + cabecera.pilotos), ocupado);
+    }
+    if (ubicado) completar_imagen(imagen, origen, hashes, ocupado);
+
+    free(ocupado);
+    free(hashes);
+    free(origen);
+    if (!ubicado){
+        free(imagen);
+        free(congelado);
+        return NULL;
+    }
+    congelado->imagen = imagen;
+    congelado->proyectado = false;
+    return congelado;
+}
+
+void *hash_congelado_obtener_bin(const hash_congelado_t *hash, const void *clave, size_t largo){
+
+    const cabecera_t* imagen = hash->imagen;
+    if (!imagen->cantidad) return NULL;
+
+    uint64_t h = hash_funcion_rapida(clave, largo, imagen->semilla);
+    const entrada_t* entrada = entrada_de(imagen, h);
+    if (entrada->largo != largo || memcmp(clave_de(imagen, entrada), clave, largo)) return NULL;
+    if (hash->proyectado) return (char*) imagen + entrada->dato;
+    return (void*) (uintptr_t) entrada->dato;
+}
+
+bool hash_congelado_pertenece_bin(const hash_congelado_t *hash, const void *clave, size_t largo){
+    const cabecera_t* imagen = hash->imagen;
+    if (!imagen->cantidad) return false;
+
+    uint64_t h = hash_funcion_rapida(clave, largo, imagen->semilla);
+    const entrada_t* entrada = entrada_de(imagen, h);
+    return entrada->largo == largo && !memcmp(clave_de(imagen, entrada), clave, largo);
+}
+
+void *hash_congelado_obtener(const hash_congelado_t *hash, const char *clave){
+    return hash_congelado_obtener_bin(hash, clave, strlen(clave));
+}
+
+bool hash_congelado_pertenece(const hash_congelado_t *hash, const char *clave){
+    return hash_congelado_pertenece_bin(hash, clave, strlen(clave));
+}
+
+size_t hash_congelado_cantidad(const hash_congelado_t *hash){
+    return (size_t) hash->imagen->cantidad;
+}
+
+void hash_congelado_destruir(hash_congelado_t *hash){
+    if (hash->proyectado) munmap(hash->imagen, (size_t) hash->imagen->largo);
+    else free(hash->imagen);
+    free(hash);
+}
+
+/* ******************************************************************
+ *                        ARCHIVOS
+ * *****************************************************************/
+
+/* Escribe la imagen tal cual hasta las entradas; las entradas con el
+ * desplazamiento de su dato en lugar del puntero, las claves largas tal cual
+ * y al final los bytes de cada dato en el orden de las entradas. */
+bool hash_congelado_guardar(const hash_congelado_t *hash, int fd, hash_serializar_dato_t serializar, void *extra){
+
+    const cabecera_t* imagen = hash->imagen;
+    if (hash->proyectado) return escribir_todo(fd, imagen, (size_t) imagen->largo);
+
+    size_t n = (size_t) imagen->cantidad;
+    const entrada_t* entradas = entradas_de(imagen);
+    entrada_t* copia = malloc((n + 1) * sizeof(entrada_t));
+    escritor_t* escritor = escritor_crear(fd);
+    if (!copia || !escritor){
+        free(copia);
+        if (escritor) escritor_destruir(escritor);
+        return false;
+    }
+
+    const void** bytes = malloc((n + 1) * sizeof(void*));
+    cabecera_t cabecera = *imagen;
+    bool ok = bytes != NULL;
+    for (size_t i = 0; ok && i < n; i++){
+        size_t largo = 0;
+        bytes[i] = serializar ? serializar((void*) (uintptr_t) entradas[i].dato, &largo, extra) : NULL;
+        ok = largo <= UINT32_MAX;
+        copia[i] = entradas[i];
+        copia[i].dato = cabecera.largo;
+        copia[i].largo_dato = (uint32_t) largo;
+        cabecera.largo += alinear(largo);
+    }
+
+    if (ok){
+        escritor_escribir(escritor, &cabecera, sizeof(cabecera));
+        escritor_escribir(escritor, imagen + 1, (size_t) imagen->entradas - sizeof(cabecera_t));
+        escritor_escribir(escritor, copia, n * sizeof(entrada_t));
+        escritor_escribir(escritor, (const char*) imagen + imagen->claves, (size_t) (imagen->largo - imagen->claves));
+        for (size_t i = 0; i < n; i++) escritor_escribir_alineado(escritor, bytes[i], copia[i].largo_dato);
+    }
+
+    ok &= escritor_destruir(escritor);
+    free(bytes);
+    free(copia);
+    return ok;
+}
+
+// Comprueba que la imagen de largo bytes sea un hash congelado completo:
+// que las secciones estén donde van, que libres lleve a posiciones menores
+// que la cantidad y que cada entrada apunte a una clave terminada en '\0' y
+// a un dato dentro de la imagen.
+static bool imagen_valida(const cabecera_t *imagen, size_t largo){
+    if (largo < sizeof(cabecera_t) || memcmp(imagen->magia, MAGIA_CONGELADO, sizeof(imagen->magia))) return false;
+    if (imagen->largo != largo || !imagen->baldes || imagen->capacidad <= imagen->cantidad) return false;
+    // Acotados primero, así las cuentas de abajo no desbordan
+    if (imagen->baldes > largo / sizeof(uint16_t) || imagen->capacidad - imagen->cantidad > largo / sizeof(uint64_t)) return false;
+    if (imagen->cantidad > largo / sizeof(entrada_t)) return false;
+    if (imagen->pilotos != sizeof(cabecera_t) || imagen->libres != alinear(imagen->pilotos + imagen->baldes * sizeof(uint16_t))) return false;
+    if (imagen->entradas != imagen->libres + (imagen->capacidad - imagen->cantidad) * sizeof(uint64_t)) return false;
+    if (imagen->claves != imagen->entradas + imagen->cantidad * sizeof(entrada_t) || imagen->claves > largo) return false;
+
+    // Vacío, libres tiene una posición que nunca se lee: buscar sale antes
+    const uint64_t* libres = libres_de(imagen);
+    for (size_t i = 0; imagen->cantidad && i < imagen->capacidad - imagen->cantidad; i++){
+        if (libres[i] >= imagen->cantidad) return false;
+    }
+    const entrada_t* entradas = entradas_de(imagen);
+    for (size_t i = 0; i < imagen->cantidad; i++){
+        const entrada_t* entrada = &entradas[i];
+        if (entrada->largo > LARGO_CLAVE_INTERNA){
+            size_t desplazamiento = (size_t) entrada->clave.desplazamiento;
+            if (desplazamiento < imagen->claves || desplazamiento >= largo) return false;
+            if (entrada->largo > largo - desplazamiento - 1) return false;
+        }
+        if (clave_de(imagen, entrada)[entrada->largo] != '\0') return false;
+        if (entrada->dato > largo || entrada->largo_dato > largo - entrada->dato) return false;
+    }
+    return true;
+}
+
+hash_congelado_t *hash_congelado_abrir(const char *ruta){
+
+    int fd = open(ruta, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat estado;
+    void* imagen = MAP_FAILED;
+    if (fstat(fd, &estado) == 0 && (size_t) estado.st_size >= sizeof(cabecera_t)){
+        imagen = mmap(NULL, (size_t) estado.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (imagen == MAP_FAILED) return NULL;
+
+    hash_congelado_t* hash = malloc(sizeof(hash_congelado_t));
+    if (!hash || !imagen_valida(imagen, (size_t) estado.st_size)){
+        munmap(imagen, (size_t) estado.st_size);
+        free(hash);
+        return NULL;
+    }
+    hash->imagen = imagen;
+    hash->proyectado = true;
+    return hash;
+}
+
+/* ******************************************************************
+ *                        ITERADOR HASH
+ * *****************************************************************/
+
+/* Las entradas no tienen huecos: el iterador las recorre en orden. */
+
+hash_congelado_iter_t *hash_congelado_iter_crear(const hash_congelado_t *hash){
+
+    hash_congelado_iter_t* iter = malloc(sizeof(hash_congelado_iter_t));
+    if(!iter) return NULL;
+
+    iter->hash = hash;
+    iter->pos = 0;
+    return iter;
+}
+
+bool hash_congelado_iter_avanzar(hash_congelado_iter_t *iter){
+
+    if (hash_congelado_iter_al_final(iter)) return false;
+
+    iter->pos++;
+    return !hash_congelado_iter_al_final(iter);
+}
+
+const char *hash_congelado_iter_ver_actual(const hash_congelado_iter_t *iter){
+    return hash_congelado_iter_ver_actual_bin(iter, NULL);
+}
+
+const void *hash_congelado_iter_ver_actual_bin(const hash_congelado_iter_t *iter, size_t *largo){
+    if (hash_congelado_iter_al_final(iter)) return NULL;
+    const cabecera_t* imagen = iter->hash->imagen;
+    const entrada_t* entrada = &entradas_de(imagen)[iter->pos];
+    if (largo) *largo = entrada->largo;
+    return clave_de(imagen, entrada);
+}
+
+bool hash_congelado_iter_al_final(const hash_congelado_iter_t *iter){
+    return iter->pos == hash_congelado_cantidad(iter->hash);
+}
+
+void hash_congelado_iter_destruir(hash_congelado_iter_t* iter){
+    free(iter);
+}
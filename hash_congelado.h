@@ -0,0 +1,77 @@
+#ifndef HASH_CONGELADO_H
+#define HASH_CONGELADO_H
+
+#include "hash.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Hash inmutable para tablas que se arman una vez y después sólo se leen.
+ * Las claves se ubican con una función de hash perfecta mínima: cada clave
+ * tiene su propia posición en un arreglo compacto de n entradas, así que
+ * buscar no sondea y compara a lo sumo una clave. Además de las entradas
+ * ocupa unos 5 bits por clave. */
+struct hash_congelado;
+struct hash_congelado_iter;
+
+typedef struct hash_congelado hash_congelado_t;
+typedef struct hash_congelado_iter hash_congelado_iter_t;
+
+/* Crea un hash congelado con las claves y los datos del hash. Las claves se
+ * copian; los datos no: el congelado guarda los mismos punteros, que siguen
+ * siendo del hash original. Devuelve NULL si no hay memoria.
+ * Pre: La estructura hash fue inicializada
+ */
+hash_congelado_t *hash_congelar(const hash_t *hash);
+
+/* Primitivas de hash.h, incluidas las de claves binarias.
+ * Pre: La estructura hash fue congelada
+ */
+void *hash_congelado_obtener(const hash_congelado_t *hash, const char *clave);
+bool hash_congelado_pertenece(const hash_congelado_t *hash, const char *clave);
+void *hash_congelado_obtener_bin(const hash_congelado_t *hash, const void *clave, size_t largo);
+bool hash_congelado_pertenece_bin(const hash_congelado_t *hash, const void *clave, size_t largo);
+size_t hash_congelado_cantidad(const hash_congelado_t *hash);
+
+/* Escribe el hash en fd, desde su posición actual, como hace
+ * hash_guardar_snapshot: cada dato se guarda con los bytes que devuelve
+ * serializar(dato, &largo, extra), o ninguno si serializar es NULL.
+ * Devuelve false si falla alguna escritura.
+ * Pre: La estructura hash fue congelada
+ */
+bool hash_congelado_guardar(const hash_congelado_t *hash, int fd, hash_serializar_dato_t serializar, void *extra);
+
+/* Abre el hash guardado al comienzo del archivo ruta proyectándolo en
+ * memoria de sólo lectura, sin leer las claves. hash_congelado_obtener
+ * devuelve un puntero a los bytes guardados del dato, que no se pueden
+ * modificar. Devuelve NULL si no se puede abrir o no es un hash congelado.
+ */
+hash_congelado_t *hash_congelado_abrir(const char *ruta);
+
+/* Destruye la estructura liberando la memoria pedida. No destruye los
+ * datos.
+ * Pre: La estructura hash fue congelada
+ * Post: La estructura hash fue destruida
+ */
+void hash_congelado_destruir(hash_congelado_t *hash);
+
+/* Iterador del hash */
+
+// Crea iterador
+hash_congelado_iter_t *hash_congelado_iter_crear(const hash_congelado_t *hash);
+
+// Avanza iterador
+bool hash_congelado_iter_avanzar(hash_congelado_iter_t *iter);
+
+// Devuelve clave actual, esa clave no se puede modificar ni liberar.
+const char *hash_congelado_iter_ver_actual(const hash_congelado_iter_t *iter);
+
+// Devuelve la clave actual y guarda su largo en largo, si no es NULL.
+const void *hash_congelado_iter_ver_actual_bin(const hash_congelado_iter_t *iter, size_t *largo);
+
+// Comprueba si terminó la iteración
+bool hash_congelado_iter_al_final(const hash_congelado_iter_t *iter);
+
+// Destruye iterador
+void hash_congelado_iter_destruir(hash_congelado_iter_t* iter);
+
+#endif // HASH_CONGELADO_H
@@ -0,0 +1,182 @@
+/*
+ * hash_congelado_pruebas.c
+ * Pruebas y mediciones para el hash congelado
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include "hash_congelado.h"
+#include "testing.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LARGO_CLAVE 40
+
+/* ******************************************************************
+ *                        PRUEBAS UNITARIAS
+ * *****************************************************************/
+
+static void prueba_hash_congelado_vacio()
+{
+    hash_t* hash = hash_crear(NULL);
+    hash_congelado_t* congelado = hash_congelar(hash);
+    print_test("Prueba hash congelado congelar vacio", congelado);
+    print_test("Prueba hash congelado la cantidad de elementos es 0", hash_congelado_cantidad(congelado) == 0);
+    print_test("Prueba hash congelado obtener en vacio es NULL", !hash_congelado_obtener(congelado, "A"));
+    print_test("Prueba hash congelado pertenece en vacio es false", !hash_congelado_pertenece(congelado, ""));
+
+    /* Un hash congelado vacío también se guarda y se vuelve a abrir */
+    char ruta[] = "/tmp/hash_congelado_XXXXXX";
+    int fd = mkstemp(ruta);
+    bool ok = fd >= 0 && hash_congelado_guardar(congelado, fd, NULL, NULL);
+    ok &= fd >= 0 && close(fd) == 0;
+    hash_congelado_t* abierto = hash_congelado_abrir(ruta);
+    print_test("Prueba hash congelado guardar y abrir vacio", ok && abierto && hash_congelado_cantidad(abierto) == 0);
+    print_test("Prueba hash congelado abierto vacio obtener es NULL", abierto && !hash_congelado_obtener(abierto, "A"));
+    if (abierto) hash_congelado_destruir(abierto);
+    unlink(ruta);
+
+    hash_congelado_iter_t* iter = hash_congelado_iter_crear(congelado);
+    print_test("Prueba hash congelado iterar vacio esta al final", hash_congelado_iter_al_final(iter));
+    print_test("Prueba hash congelado ver actual en vacio es NULL", !hash_congelado_iter_ver_actual(iter));
+    hash_congelado_iter_destruir(iter);
+
+    hash_congelado_destruir(congelado);
+    hash_destruir(hash);
+}
+
+// Guarda en el archivo el número apuntado por el dato.
+static const void *serializar_numero(void *dato, size_t *largo, void *extra)
+{
+    (void) extra;
+    *largo = sizeof(size_t);
+    return dato;
+}
+
+static void prueba_hash_congelado_volumen(size_t largo)
+{
+    hash_t* hash = hash_crear(free);
+    char clave[LARGO_CLAVE];
+    for (size_t i = 0; i < largo; i++){
+        size_t* dato = malloc(sizeof(size_t));
+        *dato = i;
+        sprintf(clave, i % 3 ? "%zu" : "una clave bastante larga %zu", i);
+        hash_guardar(hash, clave, dato);
+    }
+    size_t* binario = malloc(sizeof(size_t));
+    *binario = largo;
+    hash_guardar_bin(hash, "a\0b", 3, binario);
+
+    hash_congelado_t* congelado = hash_congelar(hash);
+    print_test("Prueba hash congelado congelar", congelado);
+    print_test("Prueba hash congelado la cantidad es la del hash", hash_congelado_cantidad(congelado) == largo + 1);
+
+    bool ok = true;
+    for (size_t i = 0; i < largo; i++){
+        sprintf(clave, i % 3 ? "%zu" : "una clave bastante larga %zu", i);
+        ok &= hash_congelado_obtener(congelado, clave) == hash_obtener(hash, clave);
+    }
+    print_test("Prueba hash congelado obtener devuelve los datos del hash", ok);
+    print_test("Prueba hash congelado clave binaria", hash_congelado_pertenece_bin(congelado, "a\0b", 3) && !hash_congelado_pertenece(congelado, "a"));
+
+    for (size_t i = largo; i < largo * 2; i++){
+        sprintf(clave, "%zu", i);
+        ok &= !hash_congelado_pertenece(congelado, clave) && !hash_congelado_obtener(congelado, clave);
+    }
+    print_test("Prueba hash congelado claves que no estan", ok);
+
+    size_t recorridas = 0;
+    hash_congelado_iter_t* iter = hash_congelado_iter_crear(congelado);
+    for (; !hash_congelado_iter_al_final(iter); hash_congelado_iter_avanzar(iter), recorridas++){
+        size_t largo_clave;
+        const void* actual = hash_congelado_iter_ver_actual_bin(iter, &largo_clave);
+        ok &= hash_pertenece_bin(hash, actual, largo_clave);
+    }
+    print_test("Prueba hash congelado iterar recorre todas las claves", ok && recorridas == largo + 1);
+    print_test("Prueba hash congelado avanzar al final es false", !hash_congelado_iter_avanzar(iter));
+    hash_congelado_iter_destruir(iter);
+
+    /* Guardado en un archivo y abierto de nuevo, los datos son sus bytes */
+    char ruta[] = "/tmp/hash_congelado_XXXXXX";
+    int fd = mkstemp(ruta);
+    ok = fd >= 0 && hash_congelado_guardar(congelado, fd, serializar_numero, NULL);
+    ok &= fd >= 0 && close(fd) == 0;
+    hash_congelado_t* abierto = hash_congelado_abrir(ruta);
+    print_test("Prueba hash congelado guardar y abrir", ok && abierto);
+    for (size_t i = 0; abierto && i < largo; i++){
+        sprintf(clave, i % 3 ? "%zu" : "una clave bastante larga %zu", i);
+        const size_t* dato = hash_congelado_obtener(abierto, clave);
+        ok &= dato && *dato == i;
+    }
+    print_test("Prueba hash congelado abierto obtener", ok && hash_congelado_cantidad(abierto) == largo + 1);
+    print_test("Prueba hash congelado abrir otro archivo es NULL", !hash_congelado_abrir("/tmp/no/existe"));
+
+    if (abierto) hash_congelado_destruir(abierto);
+
+    /* Con entradas pisadas el archivo no se abre: la mitad cae en ellas */
+    FILE* archivo = fopen(ruta, "r+b");
+    ok = archivo && fseek(archivo, 0, SEEK_END) == 0;
+    long mitad = ok ? ftell(archivo) / 2 : 0;
+    ok &= mitad > 0 && fseek(archivo, mitad, SEEK_SET) == 0;
+    for (size_t i = 0; ok && i < 4096; i++) ok &= fputc(0xff, archivo) != EOF;
+    if (archivo) ok &= fclose(archivo) == 0;
+    print_test("Prueba hash congelado abrir un archivo corrupto es NULL", ok && !hash_congelado_abrir(ruta));
+    unlink(ruta);
+    hash_congelado_destruir(congelado);
+    hash_destruir(hash);
+}
+
+/* ******************************************************************
+ *                        RENDIMIENTO
+ * *****************************************************************/
+
+static double segundos_desde(const struct timespec *inicio)
+{
+    struct timespec fin;
+    clock_gettime(CLOCK_MONOTONIC, &fin);
+    return (double) (fin.tv_sec - inicio->tv_sec) + (double) (fin.tv_nsec - inicio->tv_nsec) / 1e9;
+}
+
+/* ******************************************************************
+ *                        FUNCIÓN PRINCIPAL
+ * *****************************************************************/
+
+
+void pruebas_hash_congelado(void)
+{
+    prueba_hash_congelado_vacio();
+    prueba_hash_congelado_volumen(20000);
+}
+
+// Compara buscar todas las claves en el hash y en el congelado.
+void pruebas_volumen_congelado(size_t largo)
+{
+    hash_t* hash = hash_crear(NULL);
+    char (*claves)[LARGO_CLAVE] = malloc(largo * LARGO_CLAVE);
+    for (size_t i = 0; i < largo; i++){
+        sprintf(claves[i], "%08zu", i);
+        hash_guardar(hash, claves[i], claves[i]);
+    }
+
+    struct timespec inicio;
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    hash_congelado_t* congelado = hash_congelar(hash);
+    printf("congelar: %.3fs - ", segundos_desde(&inicio));
+
+    bool ok = congelado != NULL;
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    for (size_t i = 0; i < largo; i++) ok &= hash_obtener(hash, claves[i]) == claves[i];
+    printf("buscar en el hash: %.3fs - ", segundos_desde(&inicio));
+
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    for (size_t i = 0; ok && i < largo; i++) ok &= hash_congelado_obtener(congelado, claves[i]) == claves[i];
+    printf("en el congelado: %.3fs\n", segundos_desde(&inicio));
+    print_test("Prueba hash congelado volumen", ok);
+
+    if (congelado) hash_congelado_destruir(congelado);
+    hash_destruir(hash);
+    free(claves);
+}
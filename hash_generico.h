@@ -0,0 +1,270 @@
+#ifndef HASH_GENERICO_H
+#define HASH_GENERICO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Generador de hashes tipados.
+ *
+ * HASH_DEFINE(nombre, K, V, fhash, figual) define el tipo nombre_t, un hash
+ * de claves K a valores V, y sus primitivas como funciones static inline. El
+ * valor se guarda dentro del campo, junto a la clave, sin punteros ni
+ * reservas de memoria por elemento, y fhash y figual se llaman directamente,
+ * así que el compilador puede expandirlas en cada primitiva.
+ *
+ *   uint64_t fhash(K clave): tiene que mezclar todos los bits, porque la
+ *   posición sale de los bits bajos y la etiqueta de control de los altos.
+ *   bool figual(K a, K b): igualdad de claves.
+ *
+ * Las claves y los valores se copian por valor; el hash no es dueño de lo que
+ * apunten. Se usa en un .c, una vez por combinación de tipos:
+ *
+ *   HASH_DEFINE(hash_punto, uint32_t, punto_t, mezclar_u32, iguales_u32)
+ *
+ *   hash_punto_t* hash = hash_punto_crear();
+ *   hash_punto_guardar(hash, 7, (punto_t) {1, 2});
+ *   punto_t* punto = hash_punto_obtener(hash, 7);
+ *
+ * Sondeo lineal con un byte de control por campo: 0 es vacío y si no, el bit
+ * alto prendido más 7 bits del hash. Buscar compara los bytes de control de
+ * a grupos antes que las claves, y al borrar se corren hacia atrás los
+ * campos siguientes de la cadena, así que no hay lápidas.
+ */
+
+#define HASH_GENERICO_CAPACIDAD_INICIAL 16
+// La tabla crece cuando la carga pasaría de NUM / DEN y se achica a la mitad
+// cuando queda en 1 / HASH_GENERICO_REDUCIR
+#define HASH_GENERICO_CARGA_NUM 7
+#define HASH_GENERICO_CARGA_DEN 10
+#define HASH_GENERICO_REDUCIR 4
+// Bytes de control que se comparan juntos en cada paso de la búsqueda
+#define HASH_GENERICO_GRUPO 8
+// El byte b repetido en las 8 posiciones de una palabra
+#define HASH_GENERICO_BYTES(b) ((uint64_t) (b) * UINT64_C(0x0101010101010101))
+
+// Lee 8 bytes de control con el primero en los bits bajos.
+static inline uint64_t hash_generico_leer_grupo(const uint8_t *control){
+    uint64_t grupo;
+    memcpy(&grupo, control, sizeof(grupo));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    grupo = __builtin_bswap64(grupo);
+#endif
+    return grupo;
+}
+
+// Devuelve la palabra con el bit alto prendido en cada byte nulo de x, y
+// nada más: sin acarreos entre bytes, así que no hay falsos positivos.
+static inline uint64_t hash_generico_bytes_nulos(uint64_t x){
+    uint64_t bajos = HASH_GENERICO_BYTES(0x7f);
+    return ~(((x & bajos) + bajos) | x | bajos);
+}
+
+#define HASH_DEFINE(nombre, K, V, fhash, figual)                                        \
+                                                                                        \
+typedef struct nombre##_campo {                                                         \
+    K clave;                                                                            \
+    V valor;                                                                            \
+} nombre##_campo_t;                                                                     \
+                                                                                        \
+typedef struct nombre {                                                                 \
+    nombre##_campo_t* campos;                                                           \
+    uint8_t* control;                                                                   \
+    size_t capacidad;                                                                   \
+    size_t cantidad;                                                                    \
+} nombre##_t;                                                                           \
+                                                                                        \
+typedef struct nombre##_iter {                                                          \
+    const nombre##_t* hash;                                                             \
+    size_t pos;                                                                         \
+} nombre##_iter_t;                                                                      \
+                                                                                        \
+static inline uint8_t nombre##_etiqueta(uint64_t h){                                    \
+    return (uint8_t) (0x80 | (h >> 57));                                                \
+}                                                                                       \
+                                                                                        \
+/* Devuelve la posición de la clave o, si no está, la del vacío donde va.               \
+ * La posición inicial se mira sola primero: con un salto que casi siempre              \
+ * se acierta, el procesador pide el campo sin esperar al byte de control.              \
+ * Después lee HASH_GENERICO_GRUPO bytes de control en una palabra y los                \
+ * compara todos juntos, sin saltos: sólo compara la clave de los campos                \
+ * cuya etiqueta coincide antes del primer vacío. */                                    \
+static inline size_t nombre##_sondear(const nombre##_t *hash, K clave, uint64_t h){     \
+    uint8_t etiqueta = nombre##_etiqueta(h);                                            \
+    size_t mascara = hash->capacidad - 1;                                               \
+    size_t pos = (size_t) h & mascara;                                                  \
+    if (!hash->control[pos]) return pos;                                                \
+    if (hash->control[pos] == etiqueta && figual(hash->campos[pos].clave, clave)) return pos;\
+    while (true){                                                                       \
+        if (pos + HASH_GENERICO_GRUPO > hash->capacidad){                               \
+            /* El grupo daría la vuelta a la tabla: avanzo de a un campo */             \
+            if (!hash->control[pos]) return pos;                                        \
+            if (hash->control[pos] == etiqueta && figual(hash->campos[pos].clave, clave))\
+                return pos;                                                             \
+            pos = (pos + 1) & mascara;                                                  \
+            continue;                                                                   \
+        }                                                                               \
+        uint64_t grupo = hash_generico_leer_grupo(&hash->control[pos]);                 \
+        uint64_t candidatos = hash_generico_bytes_nulos(grupo ^ HASH_GENERICO_BYTES(etiqueta));\
+        uint64_t libres = ~grupo & HASH_GENERICO_BYTES(0x80);                           \
+        /* Solo cuentan las coincidencias antes del primer vacío */                     \
+        if (libres) candidatos &= (libres & (~libres + 1)) - 1;                         \
+        for (; candidatos; candidatos &= candidatos - 1){                               \
+            size_t i = pos + (size_t) __builtin_ctzll(candidatos) / 8;                  \
+            if (figual(hash->campos[i].clave, clave)) return i;                         \
+        }                                                                               \
+        if (libres) return pos + (size_t) __builtin_ctzll(libres) / 8;                  \
+        pos = (pos + HASH_GENERICO_GRUPO) & mascara;                                    \
+    }                                                                                   \
+}                                                                                       \
+                                                                                        \
+static inline bool nombre##_redimensionar(nombre##_t *hash, size_t capacidad_nueva){    \
+    nombre##_campo_t* campos = malloc(capacidad_nueva * sizeof(nombre##_campo_t));      \
+    uint8_t* control = calloc(capacidad_nueva, sizeof(uint8_t));                        \
+    if (!campos || !control){                                                           \
+        free(campos);                                                                   \
+        free(control);                                                                  \
+        return false;                                                                   \
+    }                                                                                   \
+    nombre##_t viejo = *hash;                                                           \
+    hash->campos = campos;                                                              \
+    hash->control = control;                                                            \
+    hash->capacidad = capacidad_nueva;                                                  \
+    for (size_t i = 0; i < viejo.capacidad; i++){                                       \
+        if (!viejo.control[i]) continue;                                                \
+        uint64_t h = fhash(viejo.campos[i].clave);                                      \
+        size_t pos = nombre##_sondear(hash, viejo.campos[i].clave, h);                  \
+        hash->control[pos] = nombre##_etiqueta(h);                                      \
+        hash->campos[pos] = viejo.campos[i];                                            \
+    }                                                                                   \
+    free(viejo.campos);                                                                 \
+    free(viejo.control);                                                                \
+    return true;                                                                        \
+}                                                                                       \
+                                                                                        \
+/* Crea el hash. Devuelve NULL si no hay memoria. */                                   \
+static inline nombre##_t *nombre##_crear(void){                                         \
+    nombre##_t* hash = malloc(sizeof(nombre##_t));                                      \
+    if (!hash) return NULL;                                                             \
+    hash->campos = NULL;                                                                \
+    hash->control = NULL;                                                               \
+    hash->capacidad = 0;                                                                \
+    hash->cantidad = 0;                                                                 \
+    if (!nombre##_redimensionar(hash, HASH_GENERICO_CAPACIDAD_INICIAL)){                \
+        free(hash);                                                                     \
+        return NULL;                                                                    \
+    }                                                                                   \
+    return hash;                                                                        \
+}                                                                                       \
+                                                                                        \
+/* Destruye el hash. Las claves y valores no se liberan. */                            \
+static inline void nombre##_destruir(nombre##_t *hash){                                 \
+    free(hash->campos);                                                                 \
+    free(hash->control);                                                                \
+    free(hash);                                                                         \
+}                                                                                       \
+                                                                                        \
+/* Devuelve un puntero al valor de la clave, que deja de ser válido cuando              \
+ * se agrega o se borra una clave. Si la clave no estaba, la agrega con el              \
+ * valor sin inicializar y pone insertado en true. Una clave que ya estaba no           \
+ * agranda la tabla. Devuelve NULL si no hay memoria. */                                \
+static inline V *nombre##_obtener_o_insertar(nombre##_t *hash, K clave, bool *insertado){ \
+    uint64_t h = fhash(clave);                                                          \
+    size_t pos = nombre##_sondear(hash, clave, h);                                      \
+    *insertado = !hash->control[pos];                                                   \
+    if (!*insertado) return &hash->campos[pos].valor;                                   \
+    if ((hash->cantidad + 1) * HASH_GENERICO_CARGA_DEN                                  \
+        > hash->capacidad * HASH_GENERICO_CARGA_NUM){                                   \
+        if (!nombre##_redimensionar(hash, hash->capacidad * 2)) return NULL;            \
+        pos = nombre##_sondear(hash, clave, h);                                         \
+    }                                                                                   \
+    hash->control[pos] = nombre##_etiqueta(h);                                          \
+    hash->campos[pos].clave = clave;                                                    \
+    hash->cantidad++;                                                                   \
+    return &hash->campos[pos].valor;                                                    \
+}                                                                                       \
+                                                                                        \
+/* Guarda el par (clave, valor), reemplazando el valor si la clave estaba.             \
+ * Devuelve false si no hay memoria. */                                                 \
+static inline bool nombre##_guardar(nombre##_t *hash, K clave, V valor){               \
+    bool insertado;                                                                     \
+    V* lugar = nombre##_obtener_o_insertar(hash, clave, &insertado);                    \
+    if (!lugar) return false;                                                           \
+    *lugar = valor;                                                                     \
+    return true;                                                                        \
+}                                                                                       \
+                                                                                        \
+/* Devuelve un puntero al valor de la clave, o NULL si no está. */                     \
+static inline V *nombre##_obtener(const nombre##_t *hash, K clave){                     \
+    size_t pos = nombre##_sondear(hash, clave, fhash(clave));                           \
+    return hash->control[pos] ? &hash->campos[pos].valor : NULL;                        \
+}                                                                                       \
+                                                                                        \
+static inline bool nombre##_pertenece(const nombre##_t *hash, K clave){                 \
+    return nombre##_obtener(hash, clave) != NULL;                                       \
+}                                                                                       \
+                                                                                        \
+static inline size_t nombre##_cantidad(const nombre##_t *hash){                         \
+    return hash->cantidad;                                                              \
+}                                                                                       \
+                                                                                        \
+/* Borra la clave y, si valor no es NULL, guarda ahí su valor. Devuelve false          \
+ * si la clave no estaba. */                                                            \
+static inline bool nombre##_borrar(nombre##_t *hash, K clave, V *valor){                \
+    size_t pos = nombre##_sondear(hash, clave, fhash(clave));                           \
+    if (!hash->control[pos]) return false;                                              \
+    if (valor) *valor = hash->campos[pos].valor;                                        \
+    size_t mascara = hash->capacidad - 1;                                               \
+    size_t hueco = pos;                                                                 \
+    for (size_t i = (pos + 1) & mascara; hash->control[i]; i = (i + 1) & mascara){      \
+        size_t inicial = (size_t) fhash(hash->campos[i].clave) & mascara;               \
+        /* i pasa al hueco si su posición inicial no está en (hueco, i] */             \
+        bool entre = hueco <= i ? (hueco < inicial && inicial <= i)                     \
+                                : (hueco < inicial || inicial <= i);                    \
+        if (entre) continue;                                                            \
+        hash->control[hueco] = hash->control[i];                                        \
+        hash->campos[hueco] = hash->campos[i];                                          \
+        hueco = i;                                                                      \
+    }                                                                                   \
+    hash->control[hueco] = 0;                                                           \
+    hash->cantidad--;                                                                   \
+    /* Si no se puede achicar, la tabla sigue sirviendo como está */                   \
+    if (hash->capacidad > HASH_GENERICO_CAPACIDAD_INICIAL                               \
+        && hash->cantidad * HASH_GENERICO_REDUCIR <= hash->capacidad)                   \
+        nombre##_redimensionar(hash, hash->capacidad / 2);                              \
+    return true;                                                                        \
+}                                                                                       \
+                                                                                        \
+/* Iterador sin reservas de memoria: se declara en la pila y se inicia con             \
+ * iter_iniciar. Modificar el hash lo invalida. */                                      \
+static inline bool nombre##_iter_al_final(const nombre##_iter_t *iter){                 \
+    return iter->pos == iter->hash->capacidad;                                          \
+}                                                                                       \
+                                                                                        \
+static inline void nombre##_iter_buscar(nombre##_iter_t *iter){                         \
+    while (!nombre##_iter_al_final(iter) && !iter->hash->control[iter->pos])            \
+        iter->pos++;                                                                    \
+}                                                                                       \
+                                                                                        \
+static inline void nombre##_iter_iniciar(nombre##_iter_t *iter, const nombre##_t *hash){ \
+    iter->hash = hash;                                                                  \
+    iter->pos = 0;                                                                      \
+    nombre##_iter_buscar(iter);                                                         \
+}                                                                                       \
+                                                                                        \
+static inline bool nombre##_iter_avanzar(nombre##_iter_t *iter){                       \
+    if (nombre##_iter_al_final(iter)) return false;                                     \
+    iter->pos++;                                                                        \
+    nombre##_iter_buscar(iter);                                                         \
+    return !nombre##_iter_al_final(iter);                                               \
+}                                                                                       \
+                                                                                        \
+/* Devuelve el campo actual con su clave y su valor.                                   \
+ * Pre: el iterador no está al final */                                                 \
+static inline const nombre##_campo_t *nombre##_iter_ver_actual(const nombre##_iter_t *iter){ \
+    return &iter->hash->campos[iter->pos];                                              \
+}
+
+#endif // HASH_GENERICO_H
@@ -0,0 +1,186 @@
+/*
+ * hash_generico_pruebas.c
+ * Pruebas para los hashes generados con HASH_DEFINE
+ */
+
+#include "hash_generico.h"
+#include "hash.h"
+#include "testing.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* Claves enteras chicas con valores struct guardados en el campo */
+typedef struct punto {
+    double x;
+    double y;
+} punto_t;
+
+static inline uint64_t mezclar_u32(uint32_t clave){
+    uint64_t h = clave * 0x9e3779b97f4a7c15ULL;
+    return h ^ (h >> 32);
+}
+
+static inline bool iguales_u32(uint32_t a, uint32_t b){
+    return a == b;
+}
+
+HASH_DEFINE(hash_punto, uint32_t, punto_t, mezclar_u32, iguales_u32)
+
+/* Claves cadena con valores enteros */
+static inline uint64_t hash_cadena(const char *clave){
+    return hash_funcion_rapida(clave, strlen(clave), 0);
+}
+
+static inline bool iguales_cadena(const char *a, const char *b){
+    return strcmp(a, b) == 0;
+}
+
+HASH_DEFINE(hash_contador, const char*, size_t, hash_cadena, iguales_cadena)
+
+/* Hash malo a propósito: pocas posiciones iniciales, al final de la tabla para
+ * que el sondeo dé la vuelta, y todas con la misma etiqueta */
+static inline uint64_t hash_choque(uint32_t clave){
+    return ~(uint64_t) (clave % 3);
+}
+
+HASH_DEFINE(hash_choques, uint32_t, uint32_t, hash_choque, iguales_u32)
+
+
+/* ******************************************************************
+ *                        PRUEBAS UNITARIAS
+ * *****************************************************************/
+
+static void prueba_hash_generico_valores_en_linea(size_t largo)
+{
+    hash_punto_t* hash = hash_punto_crear();
+    print_test("Prueba hash generico crear", hash);
+    print_test("Prueba hash generico obtener en vacio es NULL", !hash_punto_obtener(hash, 1));
+    print_test("Prueba hash generico borrar en vacio es false", !hash_punto_borrar(hash, 1, NULL));
+
+    bool ok = true;
+    for (uint32_t i = 0; i < largo; i++){
+        ok &= hash_punto_guardar(hash, i, (punto_t) {i, -(double) i});
+    }
+    print_test("Prueba hash generico guardar muchos puntos", ok && hash_punto_cantidad(hash) == largo);
+
+    for (uint32_t i = 0; i < largo; i++){
+        punto_t* punto = hash_punto_obtener(hash, i);
+        ok &= punto && punto->x == i && punto->y == -(double) i;
+    }
+    print_test("Prueba hash generico obtener devuelve el valor guardado", ok);
+
+    /* El valor se modifica en el lugar a través del puntero */
+    hash_punto_obtener(hash, 3)->x = 100;
+    print_test("Prueba hash generico modificar en el lugar", hash_punto_obtener(hash, 3)->x == 100);
+    print_test("Prueba hash generico reemplazar", hash_punto_guardar(hash, 3, (punto_t) {7, 7}));
+    print_test("Prueba hash generico reemplazar no cambia la cantidad", hash_punto_cantidad(hash) == largo);
+
+    size_t recorridos = 0;
+    hash_punto_iter_t iter;
+    for (hash_punto_iter_iniciar(&iter, hash); !hash_punto_iter_al_final(&iter); hash_punto_iter_avanzar(&iter)){
+        const hash_punto_campo_t* campo = hash_punto_iter_ver_actual(&iter);
+        ok &= campo->clave == 3 || campo->valor.x == campo->clave;
+        recorridos++;
+    }
+    print_test("Prueba hash generico iterar recorre todos", ok && recorridos == largo);
+
+    for (uint32_t i = 0; i < largo; i += 2){
+        punto_t punto;
+        ok &= hash_punto_borrar(hash, i, &punto) && punto.y == -(double) i;
+    }
+    for (uint32_t i = 0; i < largo; i++){
+        ok &= hash_punto_pertenece(hash, i) == (i % 2 == 1);
+    }
+    print_test("Prueba hash generico borrar la mitad", ok && hash_punto_cantidad(hash) == largo / 2);
+
+    for (uint32_t i = 1; i < largo; i += 2) ok &= hash_punto_borrar(hash, i, NULL);
+    print_test("Prueba hash generico borrar todos", ok && hash_punto_cantidad(hash) == 0);
+
+    hash_punto_destruir(hash);
+}
+
+static void prueba_hash_generico_claves_cadena()
+{
+    hash_contador_t* hash = hash_contador_crear();
+
+    const char* palabras[] = {"a", "rosa", "es", "una", "rosa", "es", "una", "rosa"};
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(palabras) / sizeof(palabras[0]); i++){
+        bool insertado;
+        size_t* contador = hash_contador_obtener_o_insertar(hash, palabras[i], &insertado);
+        ok &= contador != NULL;
+        if (!contador) break;
+        if (insertado) *contador = 0;
+        (*contador)++;
+    }
+    print_test("Prueba hash generico contar palabras", ok && hash_contador_cantidad(hash) == 4);
+
+    /* Una copia de la clave en otro buffer es la misma clave */
+    char rosa[] = "rosa";
+    size_t* contador = hash_contador_obtener(hash, rosa);
+    print_test("Prueba hash generico obtener con otra cadena igual", contador && *contador == 3);
+    print_test("Prueba hash generico palabra ausente", !hash_contador_pertenece(hash, "clavel"));
+
+    hash_contador_destruir(hash);
+}
+
+static void prueba_hash_generico_choques(uint32_t largo)
+{
+    hash_choques_t* hash = hash_choques_crear();
+
+    bool ok = true;
+    for (uint32_t i = 0; i < largo; i++) ok &= hash_choques_guardar(hash, i, i * 2);
+    print_test("Prueba hash generico guardar claves que chocan", ok && hash_choques_cantidad(hash) == largo);
+
+    for (uint32_t i = 0; i < largo; i++){
+        uint32_t* valor = hash_choques_obtener(hash, i);
+        ok &= valor && *valor == i * 2;
+    }
+    print_test("Prueba hash generico obtener claves que chocan", ok);
+    print_test("Prueba hash generico clave ausente entre choques", !hash_choques_pertenece(hash, largo));
+
+    for (uint32_t i = 0; i < largo; i += 3) ok &= hash_choques_borrar(hash, i, NULL);
+    for (uint32_t i = 0; i < largo; i++) ok &= hash_choques_pertenece(hash, i) == (i % 3 != 0);
+    print_test("Prueba hash generico borrar entre choques", ok);
+
+    hash_choques_destruir(hash);
+}
+
+static void prueba_hash_generico_reemplazar_en_el_limite()
+{
+    hash_punto_t* hash = hash_punto_crear();
+
+    /* Se llena hasta que la próxima clave nueva agrandaría la tabla */
+    bool ok = true;
+    uint32_t i = 0;
+    while ((hash_punto_cantidad(hash) + 1) * HASH_GENERICO_CARGA_DEN <= hash->capacidad * HASH_GENERICO_CARGA_NUM){
+        ok &= hash_punto_guardar(hash, i, (punto_t) {i, i});
+        i++;
+    }
+    size_t capacidad = hash->capacidad;
+    punto_t* punto = hash_punto_obtener(hash, 0);
+
+    bool insertado = true;
+    ok &= hash_punto_guardar(hash, 0, (punto_t) {5, 5});
+    ok &= hash_punto_obtener_o_insertar(hash, 0, &insertado) == punto && !insertado;
+    print_test("Prueba hash generico reemplazar en el limite no agranda", ok && hash->capacidad == capacidad);
+    print_test("Prueba hash generico reemplazar en el limite no mueve el valor", hash_punto_obtener(hash, 0) == punto && punto->x == 5);
+
+    ok = hash_punto_guardar(hash, i, (punto_t) {i, i});
+    print_test("Prueba hash generico clave nueva en el limite agranda", ok && hash->capacidad > capacidad);
+    hash_punto_destruir(hash);
+}
+
+/* ******************************************************************
+ *                        FUNCIÓN PRINCIPAL
+ * *****************************************************************/
+
+
+void pruebas_hash_generico(void)
+{
+    prueba_hash_generico_valores_en_linea(5000);
+    prueba_hash_generico_claves_cadena();
+    prueba_hash_generico_choques(300);
+    prueba_hash_generico_reemplazar_en_el_limite();
+}
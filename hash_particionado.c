@@ -0,0 +1,202 @@
+#define _POSIX_C_SOURCE 200809L
+#include "hash_particionado.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define LINEA_CACHE 64
+
+/* ******************************************************************
+ *                        STRUCT HASH
+ * *****************************************************************/
+
+/* Cada partición ocupa su propia línea de cache, así el lock de una no
+ * comparte línea con el de la vecina. */
+typedef union particion {
+	struct {
+		pthread_mutex_t mutex;
+		hash_t* hash;
+	} p;
+	char relleno[LINEA_CACHE];
+} particion_t;
+
+/* Todas las particiones usan la misma función de hash y semilla: la clave se
+ * hashea una vez, los bits altos eligen la partición y el mismo valor se
+ * pasa a las primitivas _h, que usan los bits bajos. */
+struct hash_particionado {
+	particion_t* particiones;
+	size_t cantidad_particiones;
+	unsigned bits;
+	hash_t* molde;              // la partición 0, para hash_calcular
+};
+
+struct hash_particionado_iter {
+	hash_iter_t** iters;
+	size_t actual;
+	size_t cantidad;
+};
+
+/* ******************************************************************
+ *                        FUNCIONES AUXILIARES
+ * *****************************************************************/
+
+// Devuelve la partición de la clave con hash h.
+static particion_t *particion_de(const hash_particionado_t *hash, uint64_t h){
+    if (!hash->bits) return &hash->particiones[0];
+    return &hash->particiones[h >> (64 - hash->bits)];
+}
+
+static void destruir_particiones(hash_particionado_t *hash, size_t cantidad){
+    for (size_t i = 0; i < cantidad; i++){
+        pthread_mutex_destroy(&hash->particiones[i].p.mutex);
+        hash_destruir(hash->particiones[i].p.hash);
+    }
+    free(hash->particiones);
+}
+
+/* ******************************************************************
+ *                        PRIMITIVAS HASH
+ * *****************************************************************/
+
+hash_particionado_t *hash_particionado_crear(hash_destruir_dato_t destruir_dato, size_t particiones){
+
+    if (!particiones) particiones = HASH_PARTICIONES_POR_DEFECTO;
+    unsigned bits = 0;
+    while (((size_t) 1 << bits) < particiones) bits++;
+
+    hash_particionado_t* hash = malloc(sizeof(hash_particionado_t));
+    if (!hash) return NULL;
+
+    void* memoria;
+    if (posix_memalign(&memoria, LINEA_CACHE, ((size_t) 1 << bits) * sizeof(particion_t))){
+        free(hash);
+        return NULL;
+    }
+    hash->particiones = memoria;
+    hash->cantidad_particiones = (size_t) 1 << bits;
+    hash->bits = bits;
+
+    hash_opciones_t opciones = { .destruir_dato = destruir_dato };
+    for (size_t i = 0; i < hash->cantidad_particiones; i++){
+        hash->particiones[i].p.hash = hash_crear_con_opciones(&opciones);
+        if (!hash->particiones[i].p.hash){
+            destruir_particiones(hash, i);
+            free(hash);
+            return NULL;
+        }
+        pthread_mutex_init(&hash->particiones[i].p.mutex, NULL);
+    }
+    hash->molde = hash->particiones[0].p.hash;
+    return hash;
+}
+
+bool hash_particionado_guardar(hash_particionado_t *hash, const char *clave, void *dato){
+    uint64_t h = hash_calcular(hash->molde, clave);
+    particion_t* particion = particion_de(hash, h);
+
+    pthread_mutex_lock(&particion->p.mutex);
+    bool guardado = hash_guardar_h(particion->p.hash, clave, h, dato);
+    pthread_mutex_unlock(&particion->p.mutex);
+    return guardado;
+}
+
+void *hash_particionado_borrar(hash_particionado_t *hash, const char *clave){
+    uint64_t h = hash_calcular(hash->molde, clave);
+    particion_t* particion = particion_de(hash, h);
+
+    pthread_mutex_lock(&particion->p.mutex);
+    void* dato = hash_borrar_h(particion->p.hash, clave, h);
+    pthread_mutex_unlock(&particion->p.mutex);
+    return dato;
+}
+
+void *hash_particionado_obtener(hash_particionado_t *hash, const char *clave){
+    uint64_t h = hash_calcular(hash->molde, clave);
+    particion_t* particion = particion_de(hash, h);
+
+    pthread_mutex_lock(&particion->p.mutex);
+    void* dato = hash_obtener_h(particion->p.hash, clave, h);
+    pthread_mutex_unlock(&particion->p.mutex);
+    return dato;
+}
+
+bool hash_particionado_pertenece(hash_particionado_t *hash, const char *clave){
+    uint64_t h = hash_calcular(hash->molde, clave);
+    particion_t* particion = particion_de(hash, h);
+
+    pthread_mutex_lock(&particion->p.mutex);
+    bool pertenece = hash_pertenece_h(particion->p.hash, clave, h);
+    pthread_mutex_unlock(&particion->p.mutex);
+    return pertenece;
+}
+
+size_t hash_particionado_cantidad(hash_particionado_t *hash){
+    size_t cantidad = 0;
+    for (size_t i = 0; i < hash->cantidad_particiones; i++){
+        pthread_mutex_lock(&hash->particiones[i].p.mutex);
+        cantidad += hash_cantidad(hash->particiones[i].p.hash);
+        pthread_mutex_unlock(&hash->particiones[i].p.mutex);
+    }
+    return cantidad;
+}
+
+void hash_particionado_destruir(hash_particionado_t *hash){
+    destruir_particiones(hash, hash->cantidad_particiones);
+    free(hash);
+}
+
+/* ******************************************************************
+ *                        ITERADOR HASH
+ * *****************************************************************/
+
+// Deja actual en la primera partición desde actual que no terminó.
+static void buscar_particion(hash_particionado_iter_t *iter){
+    while (iter->actual < iter->cantidad && hash_iter_al_final(iter->iters[iter->actual])) iter->actual++;
+}
+
+hash_particionado_iter_t *hash_particionado_iter_crear(hash_particionado_t *hash){
+
+    hash_particionado_iter_t* iter = malloc(sizeof(hash_particionado_iter_t));
+    if(!iter) return NULL;
+
+    iter->iters = malloc(hash->cantidad_particiones * sizeof(hash_iter_t*));
+    if (!iter->iters){
+        free(iter);
+        return NULL;
+    }
+    for (iter->cantidad = 0; iter->cantidad < hash->cantidad_particiones; iter->cantidad++){
+        hash_iter_t* particion = hash_iter_crear(hash->particiones[iter->cantidad].p.hash);
+        if (!particion){
+            hash_particionado_iter_destruir(iter);
+            return NULL;
+        }
+        iter->iters[iter->cantidad] = particion;
+    }
+    iter->actual = 0;
+    buscar_particion(iter);
+    return iter;
+}
+
+bool hash_particionado_iter_avanzar(hash_particionado_iter_t *iter){
+
+	if (hash_particionado_iter_al_final(iter)) return false;
+
+    hash_iter_avanzar(iter->iters[iter->actual]);
+    buscar_particion(iter);
+	return !hash_particionado_iter_al_final(iter);
+}
+
+const char *hash_particionado_iter_ver_actual(const hash_particionado_iter_t *iter){
+    if (hash_particionado_iter_al_final(iter)) return NULL;
+    return hash_iter_ver_actual(iter->iters[iter->actual]);
+}
+
+bool hash_particionado_iter_al_final(const hash_particionado_iter_t *iter){
+    return iter->actual == iter->cantidad;
+}
+
+void hash_particionado_iter_destruir(hash_particionado_iter_t* iter){
+    for (size_t i = 0; i < iter->cantidad; i++) hash_iter_destruir(iter->iters[i]);
+    free(iter->iters);
+	free(iter);
+}
@@ -0,0 +1,65 @@
+#ifndef HASH_PARTICIONADO_H
+#define HASH_PARTICIONADO_H
+
+#include "hash.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Hash para muchos hilos que escriben a la vez. Las claves se reparten por
+ * los bits altos de su hash entre particiones independientes, cada una un
+ * hash_t con su propio lock, así escrituras en particiones distintas no se
+ * esperan y cada partición se redimensiona por su cuenta. */
+struct hash_particionado;
+struct hash_particionado_iter;
+
+typedef struct hash_particionado hash_particionado_t;
+typedef struct hash_particionado_iter hash_particionado_iter_t;
+
+#define HASH_PARTICIONES_POR_DEFECTO 64
+
+/* Crea el hash con particiones particiones, redondeado a la potencia de 2
+ * siguiente; con 0 usa HASH_PARTICIONES_POR_DEFECTO.
+ */
+hash_particionado_t *hash_particionado_crear(hash_destruir_dato_t destruir_dato, size_t particiones);
+
+/* Primitivas de hash.h. Cada una toma solamente el lock de la partición de
+ * la clave, y hashea la clave antes de tomarlo.
+ * Pre: La estructura hash fue inicializada
+ */
+bool hash_particionado_guardar(hash_particionado_t *hash, const char *clave, void *dato);
+void *hash_particionado_borrar(hash_particionado_t *hash, const char *clave);
+void *hash_particionado_obtener(hash_particionado_t *hash, const char *clave);
+bool hash_particionado_pertenece(hash_particionado_t *hash, const char *clave);
+
+/* Devuelve la cantidad de elementos, sumando la de cada partición. Con
+ * escritores concurrentes es un valor aproximado.
+ * Pre: La estructura hash fue inicializada
+ */
+size_t hash_particionado_cantidad(hash_particionado_t *hash);
+
+/* Destruye la estructura liberando la memoria pedida y llamando a la función
+ * destruir para cada dato. Ningún otro hilo puede estar usando el hash.
+ * Pre: La estructura hash fue inicializada
+ * Post: La estructura hash fue destruida
+ */
+void hash_particionado_destruir(hash_particionado_t *hash);
+
+/* Iterador del hash: recorre una partición después de otra. No se puede
+ * modificar el hash mientras se itera. */
+
+// Crea iterador
+hash_particionado_iter_t *hash_particionado_iter_crear(hash_particionado_t *hash);
+
+// Avanza iterador
+bool hash_particionado_iter_avanzar(hash_particionado_iter_t *iter);
+
+// Devuelve clave actual, esa clave no se puede modificar ni liberar.
+const char *hash_particionado_iter_ver_actual(const hash_particionado_iter_t *iter);
+
+// Comprueba si terminó la iteración
+bool hash_particionado_iter_al_final(const hash_particionado_iter_t *iter);
+
+// Destruye iterador
+void hash_particionado_iter_destruir(hash_particionado_iter_t* iter);
+
+#endif // HASH_PARTICIONADO_H
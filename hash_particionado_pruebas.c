@@ -0,0 +1,151 @@
+/*
+ * hash_particionado_pruebas.c
+ * Pruebas y mediciones para el hash particionado
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include "hash_particionado.h"
+#include "testing.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define LARGO_CLAVE 32
+
+/* ******************************************************************
+ *                        PRUEBAS UNITARIAS
+ * *****************************************************************/
+
+static void prueba_hash_particionado_un_hilo()
+{
+    hash_particionado_t* hash = hash_particionado_crear(NULL, 5);
+    print_test("Prueba hash particionado crear", hash);
+    print_test("Prueba hash particionado la cantidad de elementos es 0", hash_particionado_cantidad(hash) == 0);
+
+    hash_particionado_iter_t* iter = hash_particionado_iter_crear(hash);
+    print_test("Prueba hash particionado iterar vacio esta al final", hash_particionado_iter_al_final(iter));
+    print_test("Prueba hash particionado ver actual en vacio es NULL", !hash_particionado_iter_ver_actual(iter));
+    hash_particionado_iter_destruir(iter);
+
+    char *clave1 = "perro", *valor1 = "guau";
+    char *clave2 = "gato", *valor2 = "miau";
+    print_test("Prueba hash particionado guardar clave1", hash_particionado_guardar(hash, clave1, valor1));
+    print_test("Prueba hash particionado guardar clave2", hash_particionado_guardar(hash, clave2, valor2));
+    print_test("Prueba hash particionado reemplazar clave2", hash_particionado_guardar(hash, clave2, valor1));
+    print_test("Prueba hash particionado la cantidad de elementos es 2", hash_particionado_cantidad(hash) == 2);
+    print_test("Prueba hash particionado obtener clave2", hash_particionado_obtener(hash, clave2) == valor1);
+    print_test("Prueba hash particionado borrar clave1", hash_particionado_borrar(hash, clave1) == valor1);
+    print_test("Prueba hash particionado clave1 no pertenece", !hash_particionado_pertenece(hash, clave1));
+    print_test("Prueba hash particionado clave2 pertenece", hash_particionado_pertenece(hash, clave2));
+
+    hash_particionado_destruir(hash);
+}
+
+typedef struct insercion {
+    hash_particionado_t* hash;
+    size_t desde;
+    size_t hasta;
+    bool ok;
+} insercion_t;
+
+static void *insertar(void *arg)
+{
+    insercion_t* insercion = arg;
+    char clave[LARGO_CLAVE];
+    insercion->ok = true;
+    for (size_t i = insercion->desde; i < insercion->hasta; i++){
+        sprintf(clave, "%08zu", i);
+        insercion->ok &= hash_particionado_guardar(insercion->hash, clave, NULL);
+    }
+    return NULL;
+}
+
+// Inserta las claves 0..largo-1 repartidas entre hilos hilos.
+static bool insertar_en_paralelo(hash_particionado_t *hash, size_t largo, size_t hilos)
+{
+    pthread_t* ids = malloc(hilos * sizeof(pthread_t));
+    insercion_t* inserciones = malloc(hilos * sizeof(insercion_t));
+    for (size_t i = 0; i < hilos; i++){
+        inserciones[i] = (insercion_t) {hash, largo * i / hilos, largo * (i + 1) / hilos, false};
+        pthread_create(&ids[i], NULL, insertar, &inserciones[i]);
+    }
+    bool ok = true;
+    for (size_t i = 0; i < hilos; i++){
+        pthread_join(ids[i], NULL);
+        ok &= inserciones[i].ok;
+    }
+    free(inserciones);
+    free(ids);
+    return ok;
+}
+
+static void prueba_hash_particionado_hilos(size_t largo, size_t hilos)
+{
+    hash_particionado_t* hash = hash_particionado_crear(NULL, 0);
+
+    print_test("Prueba hash particionado guardar desde varios hilos", insertar_en_paralelo(hash, largo, hilos));
+    print_test("Prueba hash particionado la cantidad es la suma de las particiones", hash_particionado_cantidad(hash) == largo);
+
+    bool ok = true;
+    char clave[LARGO_CLAVE];
+    for (size_t i = 0; i < largo; i++){
+        sprintf(clave, "%08zu", i);
+        ok &= hash_particionado_pertenece(hash, clave);
+    }
+    print_test("Prueba hash particionado pertenecen todas las claves", ok);
+
+    size_t recorridos = 0;
+    hash_particionado_iter_t* iter = hash_particionado_iter_crear(hash);
+    while (!hash_particionado_iter_al_final(iter)){
+        ok &= hash_particionado_pertenece(hash, hash_particionado_iter_ver_actual(iter));
+        recorridos++;
+        hash_particionado_iter_avanzar(iter);
+    }
+    hash_particionado_iter_destruir(iter);
+    print_test("Prueba hash particionado iterar recorre todas las particiones", ok && recorridos == largo);
+
+    hash_particionado_destruir(hash);
+}
+
+/* ******************************************************************
+ *                        RENDIMIENTO
+ * *****************************************************************/
+
+// Inserciones por segundo, en millones, con hilos hilos y particiones
+// particiones; con una sola partición es un hash_t detrás de un lock global.
+static double medir_inserciones(size_t largo, size_t hilos, size_t particiones)
+{
+    hash_particionado_t* hash = hash_particionado_crear(NULL, particiones);
+
+    struct timespec inicio, fin;
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    insertar_en_paralelo(hash, largo, hilos);
+    clock_gettime(CLOCK_MONOTONIC, &fin);
+
+    hash_particionado_destruir(hash);
+    double segundos = (double) (fin.tv_sec - inicio.tv_sec) + (double) (fin.tv_nsec - inicio.tv_nsec) / 1e9;
+    return (double) largo / segundos / 1e6;
+}
+
+/* ******************************************************************
+ *                        FUNCIÓN PRINCIPAL
+ * *****************************************************************/
+
+
+void pruebas_hash_particionado(void)
+{
+    prueba_hash_particionado_un_hilo();
+    prueba_hash_particionado_hilos(20000, 8);
+}
+
+void pruebas_volumen_particionado(size_t largo)
+{
+    printf("hilos - particionado Mops/s - un lock global Mops/s\n");
+    for (size_t hilos = 1; hilos <= 64; hilos *= 2){
+        double particionado = medir_inserciones(largo, hilos, HASH_PARTICIONES_POR_DEFECTO);
+        double global = medir_inserciones(largo, hilos, 1);
+        printf("%5zu - %8.2f - %8.2f\n", hilos, particionado, global);
+    }
+}
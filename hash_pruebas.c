@@ -5,12 +5,14 @@
  * Licencia: CC-BY-SA 2.5 (ar) ó CC-BY-SA 3.0
  */
 
+#define _POSIX_C_SOURCE 200809L
 #include "hash.h"
 #include "testing.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>  // For ssize_t in Linux.
 
 
@@ -392,6 +394,1121 @@ static void prueba_hash_iterar_volumen(size_t largo)
     hash_destruir(hash);
 }
 
+static uint64_t hash_constante(const void *clave, size_t largo, uint64_t semilla)
+{
+    (void) clave;
+    (void) largo;
+    return semilla;
+}
+
+static void prueba_hash_funcion_propia()
+{
+    hash_opciones_t opciones = { .funcion_hash = hash_constante, .semilla = 7 };
+    hash_t* hash = hash_crear_con_opciones(&opciones);
+
+    const size_t largo = 100;
+    char claves[largo][10];
+
+    /* Todas las claves colisionan: el hash debe seguir funcionando */
+    bool ok = true;
+    for (size_t i = 0; i < largo; i++) {
+        sprintf(claves[i], "%08zu", i);
+        ok &= hash_guardar(hash, claves[i], claves[i]);
+    }
+    print_test("Prueba hash funcion propia guardar claves que colisionan", ok);
+    print_test("Prueba hash funcion propia la cantidad es correcta", hash_cantidad(hash) == largo);
+
+    ok = true;
+    for (size_t i = 0; i < largo; i++) {
+        ok &= hash_obtener(hash, claves[i]) == claves[i];
+    }
+    print_test("Prueba hash funcion propia obtener claves que colisionan", ok);
+
+    ok = true;
+    for (size_t i = 0; i < largo; i += 2) {
+        ok &= hash_borrar(hash, claves[i]) == claves[i];
+    }
+    for (size_t i = 1; i < largo; i += 2) {
+        ok &= hash_pertenece(hash, claves[i]);
+    }
+    print_test("Prueba hash funcion propia borrar la mitad", ok);
+
+    hash_destruir(hash);
+}
+
+static void prueba_hash_funcion_rapida()
+{
+    const char *clave = "https://www.ejemplo.com.ar/una/ruta/bastante/larga?con=parametros";
+    size_t largo = strlen(clave);
+
+    print_test("Prueba hash funcion rapida es determinista",
+               hash_funcion_rapida(clave, largo, 0) == hash_funcion_rapida(clave, largo, 0));
+    print_test("Prueba hash funcion rapida depende de la semilla",
+               hash_funcion_rapida(clave, largo, 0) != hash_funcion_rapida(clave, largo, 1));
+    print_test("Prueba hash funcion rapida depende del largo",
+               hash_funcion_rapida(clave, largo, 0) != hash_funcion_rapida(clave, largo - 1, 0));
+}
+
+static void prueba_hash_borrar_e_insertar_alternado(size_t largo)
+{
+    hash_t* hash = hash_crear(NULL);
+
+    const size_t largo_clave = 10;
+    char (*claves)[largo_clave] = malloc(2 * largo * largo_clave);
+    for (size_t i = 0; i < 2 * largo; i++) {
+        sprintf(claves[i], "%08zu", i);
+    }
+
+    /* Mantiene siempre 'largo' claves vivas, borrando la más vieja en cada
+     * inserción, como un cache de sesiones. */
+    bool ok = true;
+    for (size_t i = 0; i < largo; i++) {
+        ok &= hash_guardar(hash, claves[i], claves[i]);
+    }
+    for (size_t i = largo; i < 2 * largo && ok; i++) {
+        ok &= hash_borrar(hash, claves[i - largo]) == claves[i - largo];
+        ok &= hash_guardar(hash, claves[i], claves[i]);
+        ok &= hash_cantidad(hash) == largo;
+    }
+    print_test("Prueba hash borrar e insertar alternado", ok);
+
+    ok = true;
+    for (size_t i = 0; i < 2 * largo; i++) {
+        bool vivo = i >= largo;
+        ok &= hash_pertenece(hash, claves[i]) == vivo;
+        ok &= hash_obtener(hash, claves[i]) == (vivo ? claves[i] : NULL);
+    }
+    print_test("Prueba hash borrar e insertar alternado, quedan solo las claves vivas", ok);
+
+    free(claves);
+    hash_destruir(hash);
+}
+
+static void prueba_hash_motor_grupos(size_t largo, hash_funcion_t funcion)
+{
+    hash_opciones_t opciones = { .motor = HASH_MOTOR_GRUPOS, .funcion_hash = funcion };
+    hash_t* hash = hash_crear_con_opciones(&opciones);
+
+    const size_t largo_clave = 10;
+    char (*claves)[largo_clave] = malloc(largo * largo_clave);
+
+    bool ok = true;
+    for (size_t i = 0; i < largo; i++) {
+        sprintf(claves[i], "%08zu", i);
+        ok &= hash_guardar(hash, claves[i], claves[i]);
+    }
+    print_test("Prueba hash motor grupos guardar muchos elementos", ok);
+
+    ok = !hash_pertenece(hash, "no esta");
+    for (size_t i = 0; i < largo; i++) {
+        ok &= hash_obtener(hash, claves[i]) == claves[i];
+    }
+    print_test("Prueba hash motor grupos obtener muchos elementos", ok);
+
+    ok = true;
+    for (size_t i = 0; i < largo; i += 2) {
+        ok &= hash_borrar(hash, claves[i]) == claves[i];
+    }
+    for (size_t i = 0; i < largo; i++) {
+        ok &= hash_pertenece(hash, claves[i]) == (i % 2 == 1);
+    }
+    print_test("Prueba hash motor grupos borrar la mitad", ok);
+    print_test("Prueba hash motor grupos la cantidad es correcta", hash_cantidad(hash) == largo / 2);
+
+    free(claves);
+    hash_destruir(hash);
+}
+
+static void prueba_hash_arena_claves(size_t largo)
+{
+    hash_opciones_t opciones = { .destruir_dato = free, .arena_claves = true };
+    hash_t* hash = hash_crear_con_opciones(&opciones);
+
+    /* Claves de largos variados, algunas más grandes que una clase de la arena */
+    char clave[600];
+    bool ok = true;
+    for (size_t i = 0; i < largo; i++) {
+        size_t relleno = (i * 37) % 550;
+        memset(clave, 'x', relleno);
+        sprintf(clave + relleno, "%zu", i);
+        size_t *valor = malloc(sizeof(size_t));
+        *valor = i;
+        ok &= hash_guardar(hash, clave, valor);
+    }
+    print_test("Prueba hash arena guardar claves de distintos largos", ok);
+    print_test("Prueba hash arena la cantidad es correcta", hash_cantidad(hash) == largo);
+
+    /* Borra la mitad y la vuelve a insertar, reutilizando bloques liberados */
+    ok = true;
+    for (int vuelta = 0; vuelta < 2; vuelta++) {
+        for (size_t i = 0; i < largo; i += 2) {
+            size_t relleno = (i * 37) % 550;
+            memset(clave, 'x', relleno);
+            sprintf(clave + relleno, "%zu", i);
+            if (vuelta == 0) {
+                size_t *valor = hash_borrar(hash, clave);
+                ok &= valor && *valor == i;
+                free(valor);
+            } else {
+                size_t *valor = malloc(sizeof(size_t));
+                *valor = i;
+                ok &= hash_guardar(hash, clave, valor);
+            }
+        }
+    }
+    print_test("Prueba hash arena borrar y volver a guardar", ok);
+
+    ok = true;
+    for (size_t i = 0; i < largo; i++) {
+        size_t relleno = (i * 37) % 550;
+        memset(clave, 'x', relleno);
+        sprintf(clave + relleno, "%zu", i);
+        size_t *valor = hash_obtener(hash, clave);
+        ok &= valor && *valor == i;
+    }
+    print_test("Prueba hash arena obtener todas las claves", ok);
+
+    hash_destruir(hash);
+}
+
+static void prueba_hash_claves_de_todos_los_largos()
+{
+    hash_t* hash = hash_crear(NULL);
+
+    /* Claves que quedan dentro del campo y claves que van aparte */
+    const size_t largo_max = 40;
+    char claves[largo_max + 1][largo_max + 1];
+    bool ok = true;
+    for (size_t i = 0; i <= largo_max; i++) {
+        memset(claves[i], 'a' + (int) (i % 26), i);
+        claves[i][i] = '\0';
+        ok &= hash_guardar(hash, claves[i], claves[i]);
+    }
+    print_test("Prueba hash guardar claves de todos los largos", ok);
+
+    ok = true;
+    for (size_t i = 0; i <= largo_max; i++) {
+        ok &= hash_obtener(hash, claves[i]) == claves[i];
+    }
+    print_test("Prueba hash obtener claves de todos los largos", ok);
+
+    /* El iterador devuelve copias iguales a las claves originales */
+    ok = true;
+    size_t recorridas = 0;
+    hash_iter_t* iter = hash_iter_crear(hash);
+    for (; !hash_iter_al_final(iter); hash_iter_avanzar(iter), recorridas++) {
+        const char *clave = hash_iter_ver_actual(iter);
+        ok &= strlen(clave) <= largo_max && strcmp(clave, claves[strlen(clave)]) == 0;
+    }
+    hash_iter_destruir(iter);
+    print_test("Prueba hash iterar claves de todos los largos", ok && recorridas == largo_max + 1);
+
+    hash_destruir(hash);
+}
+
+static size_t contar_iterando(const hash_t* hash)
+{
+    size_t cantidad = 0;
+    hash_iter_t* iter = hash_iter_crear(hash);
+    for (; !hash_iter_al_final(iter); hash_iter_avanzar(iter)) {
+        if (hash_obtener(hash, hash_iter_ver_actual(iter))) cantidad++;
+    }
+    hash_iter_destruir(iter);
+    return cantidad;
+}
+
+static void prueba_hash_redimension_incremental(size_t largo, hash_motor_t motor)
+{
+    hash_opciones_t opciones = { .redimension_incremental = true, .motor = motor };
+    hash_t* hash = hash_crear_con_opciones(&opciones);
+
+    const size_t largo_clave = 10;
+    char (*claves)[largo_clave] = malloc(largo * largo_clave);
+
+    /* Después de cada inserción todo lo guardado debe seguir visible, aunque
+     * esté en la tabla vieja */
+    bool ok = true;
+    bool ok_iterar = true;
+    for (size_t i = 0; i < largo; i++) {
+        sprintf(claves[i], "%08zu", i);
+        ok &= hash_guardar(hash, claves[i], claves[i]);
+        ok &= hash_obtener(hash, claves[i / 2]) == claves[i / 2];
+        if (i % 97 == 0) ok_iterar &= contar_iterando(hash) == i + 1;
+    }
+    print_test("Prueba hash incremental guardar muchos elementos", ok);
+    print_test("Prueba hash incremental iterar durante la migracion", ok_iterar);
+
+    ok = true;
+    for (size_t i = 0; i < largo; i++) {
+        ok &= hash_obtener(hash, claves[i]) == claves[i];
+    }
+    print_test("Prueba hash incremental obtener muchos elementos", ok);
+
+    /* Borra todo, pasando por las migraciones al achicar */
+    ok = true;
+    ok_iterar = true;
+    for (size_t i = 0; i < largo; i++) {
+        ok &= hash_borrar(hash, claves[i]) == claves[i];
+        ok &= i + 1 == largo || hash_pertenece(hash, claves[largo - 1]);
+        if (i % 97 == 0) ok_iterar &= contar_iterando(hash) == largo - i - 1;
+    }
+    print_test("Prueba hash incremental borrar muchos elementos", ok);
+    print_test("Prueba hash incremental iterar mientras se achica", ok_iterar);
+    print_test("Prueba hash incremental la cantidad es 0", hash_cantidad(hash) == 0);
+
+    free(claves);
+    hash_destruir(hash);
+}
+
+static void prueba_hash_reservar_y_guardar_lote(size_t largo)
+{
+    hash_t* hash = hash_crear_con_capacidad(NULL, largo);
+    print_test("Prueba hash crear con capacidad", hash);
+    print_test("Prueba hash crear con capacidad esta vacio", hash_cantidad(hash) == 0);
+
+    const size_t largo_clave = 10;
+    char (*buffer)[largo_clave] = malloc(largo * largo_clave);
+    const char **claves = malloc(largo * sizeof(char*));
+    void **datos = malloc(largo * sizeof(void*));
+    for (size_t i = 0; i < largo; i++) {
+        sprintf(buffer[i], "%08zu", i);
+        claves[i] = buffer[i];
+        datos[i] = buffer[i];
+    }
+
+    /* Guarda la primera mitad de a una y todo junto en un lote: la primera
+     * mitad se reemplaza */
+    bool ok = true;
+    for (size_t i = 0; i < largo / 2; i++) {
+        ok &= hash_guardar(hash, claves[i], NULL);
+    }
+    ok &= hash_guardar_lote(hash, claves, datos, largo);
+    print_test("Prueba hash guardar lote", ok);
+    print_test("Prueba hash guardar lote la cantidad es correcta", hash_cantidad(hash) == largo);
+
+    ok = true;
+    for (size_t i = 0; i < largo; i++) {
+        ok &= hash_obtener(hash, claves[i]) == datos[i];
+    }
+    print_test("Prueba hash guardar lote obtener todos los elementos", ok);
+
+    /* Un lote con claves repetidas se queda con el último dato */
+    const char *repetidas[] = {"a", "b", "a"};
+    void *valores[] = {buffer[0], buffer[1], buffer[2]};
+    ok = hash_guardar_lote(hash, repetidas, valores, 3);
+    print_test("Prueba hash guardar lote con claves repetidas", ok && hash_obtener(hash, "a") == buffer[2]);
+
+    print_test("Prueba hash reservar", hash_reservar(hash, 4 * largo));
+    print_test("Prueba hash reservar mantiene los elementos", hash_obtener(hash, claves[largo - 1]) == datos[largo - 1]);
+    print_test("Prueba hash reservar demasiado es false", !hash_reservar(hash, SIZE_MAX) && !hash_reservar(hash, SIZE_MAX / 4));
+    print_test("Prueba hash reservar demasiado no cambia nada", hash_obtener(hash, claves[largo - 1]) == datos[largo - 1]);
+    print_test("Prueba hash crear con demasiada capacidad es NULL", !hash_crear_con_capacidad(NULL, SIZE_MAX));
+
+    free(buffer);
+    free(claves);
+    free(datos);
+    hash_destruir(hash);
+}
+
+static void prueba_hash_politica_invalida()
+{
+    hash_politica_t politica = hash_politica_por_defecto();
+    politica.carga_maxima = 1;
+    hash_opciones_t opciones = { .politica = &politica };
+    print_test("Prueba hash politica con carga maxima 1 es invalida", !hash_crear_con_opciones(&opciones));
+
+    politica = hash_politica_por_defecto();
+    politica.carga_minima = politica.carga_maxima;
+    print_test("Prueba hash politica con carga minima igual a la maxima es invalida", !hash_crear_con_opciones(&opciones));
+
+    politica = hash_politica_por_defecto();
+    politica.factor_crecimiento = 1;
+    print_test("Prueba hash politica con factor 1 es invalida", !hash_crear_con_opciones(&opciones));
+
+    hash_t* hash = hash_crear(NULL);
+    print_test("Prueba hash cambiar a politica invalida devuelve false", !hash_cambiar_politica(hash, &politica));
+    hash_destruir(hash);
+}
+
+/* Guarda y borra alrededor del umbral de achicado con la política dada */
+static void prueba_hash_politica_oscilante(const hash_politica_t *politica, size_t largo)
+{
+    hash_opciones_t opciones = { .politica = politica };
+    hash_t* hash = hash_crear_con_opciones(&opciones);
+    print_test("Prueba hash crear con politica", hash);
+
+    const size_t largo_clave = 10;
+    char (*claves)[largo_clave] = malloc(largo * largo_clave);
+
+    bool ok = true;
+    for (size_t i = 0; i < largo; i++) {
+        sprintf(claves[i], "%08zu", i);
+        ok &= hash_guardar(hash, claves[i], claves[i]);
+    }
+    for (size_t vuelta = 0; vuelta < 20; vuelta++) {
+        for (size_t i = largo / 2; i < largo; i++) {
+            ok &= hash_borrar(hash, claves[i]) == claves[i];
+        }
+        for (size_t i = largo / 2; i < largo; i++) {
+            ok &= hash_guardar(hash, claves[i], claves[i]);
+        }
+    }
+    for (size_t i = 0; i < largo; i++) {
+        ok &= hash_obtener(hash, claves[i]) == claves[i];
+    }
+    print_test("Prueba hash politica guardar y borrar oscilando", ok && hash_cantidad(hash) == largo);
+
+    free(claves);
+    hash_destruir(hash);
+}
+
+static void prueba_hash_politicas()
+{
+    prueba_hash_politica_invalida();
+
+    hash_politica_t politica = hash_politica_por_defecto();
+    prueba_hash_politica_oscilante(&politica, 1000);
+
+    politica.reducir = false;
+    prueba_hash_politica_oscilante(&politica, 1000);
+
+    politica = hash_politica_por_defecto();
+    politica.carga_maxima = 0.9;
+    politica.carga_minima = 0.5;
+    politica.factor_crecimiento = 3;
+    politica.histeresis = 0;
+    prueba_hash_politica_oscilante(&politica, 1000);
+}
+
+static void *sumar_uno(const char *clave, void *dato, bool existia, void *extra)
+{
+    (void) clave;
+    size_t *insertadas = extra;
+    if (!existia) (*insertadas)++;
+    return (void *) ((size_t) dato + 1);
+}
+
+static void prueba_hash_contadores(size_t largo)
+{
+    hash_t* hash = hash_crear(NULL);
+    char clave[24];
+
+    /* Cuenta apariciones de largo / 10 claves distintas */
+    bool ok = true;
+    size_t insertadas = 0;
+    for (size_t i = 0; i < largo; i++) {
+        sprintf(clave, "%zu", i % (largo / 10));
+        bool insertado;
+        void **dato = hash_obtener_o_insertar(hash, clave, &insertado);
+        ok &= dato != NULL && insertado == (i < largo / 10);
+        if (!dato) break;
+        if (insertado) insertadas++;
+        *dato = (void *) ((size_t) *dato + 1);
+    }
+    print_test("Prueba hash obtener o insertar", ok && insertadas == largo / 10);
+    print_test("Prueba hash obtener o insertar la cantidad es correcta", hash_cantidad(hash) == largo / 10);
+
+    ok = true;
+    for (size_t i = 0; i < largo / 10; i++) {
+        sprintf(clave, "%zu", i);
+        ok &= (size_t) hash_obtener(hash, clave) == 10;
+    }
+    print_test("Prueba hash obtener o insertar cuenta bien", ok);
+
+    /* Lo mismo con hash_actualizar, sobre claves viejas y nuevas */
+    ok = true;
+    insertadas = 0;
+    for (size_t i = 0; i < largo / 5; i++) {
+        sprintf(clave, "%zu", i);
+        ok &= hash_actualizar(hash, clave, sumar_uno, &insertadas);
+    }
+    print_test("Prueba hash actualizar", ok && insertadas == largo / 10);
+
+    ok = true;
+    for (size_t i = 0; i < largo / 5; i++) {
+        sprintf(clave, "%zu", i);
+        ok &= (size_t) hash_obtener(hash, clave) == (i < largo / 10 ? 11 : 1);
+    }
+    print_test("Prueba hash actualizar cuenta bien", ok);
+
+    hash_destruir(hash);
+}
+
+static void prueba_hash_precalculado()
+{
+    /* Dos hashes con la misma función y semilla comparten el hash de la clave */
+    hash_opciones_t opciones = { .semilla = 42 };
+    hash_t* hash1 = hash_crear_con_opciones(&opciones);
+    hash_t* hash2 = hash_crear_con_opciones(&opciones);
+
+    char *clave = "tenant/usuario/12345", *valor1 = "uno", *valor2 = "dos";
+    uint64_t h = hash_calcular(hash1, clave);
+    print_test("Prueba hash calcular es igual en hashes con la misma semilla", h == hash_calcular(hash2, clave));
+
+    print_test("Prueba hash guardar_h en el primer hash", hash_guardar_h(hash1, clave, h, valor1));
+    print_test("Prueba hash guardar_h en el segundo hash", hash_guardar_h(hash2, clave, h, valor2));
+    print_test("Prueba hash obtener_h en el primer hash", hash_obtener_h(hash1, clave, h) == valor1);
+    print_test("Prueba hash obtener_h en el segundo hash", hash_obtener_h(hash2, clave, h) == valor2);
+    print_test("Prueba hash obtener sin _h encuentra la clave", hash_obtener(hash1, clave) == valor1);
+    print_test("Prueba hash pertenece_h", hash_pertenece_h(hash2, clave, h));
+
+    bool insertado;
+    void **dato = hash_obtener_o_insertar_h(hash1, clave, h, &insertado);
+    print_test("Prueba hash obtener_o_insertar_h encuentra la clave", dato && *dato == valor1 && !insertado);
+
+    print_test("Prueba hash borrar_h", hash_borrar_h(hash1, clave, h) == valor1);
+    print_test("Prueba hash pertenece_h despues de borrar", !hash_pertenece_h(hash1, clave, h));
+    print_test("Prueba hash el otro hash no cambia", hash_obtener(hash2, clave) == valor2);
+
+    hash_destruir(hash1);
+    hash_destruir(hash2);
+}
+
+static void prueba_hash_claves_binarias(size_t largo)
+{
+    hash_t* hash = hash_crear(NULL);
+
+    /* Claves de 16 bytes con ceros en el medio, como un UUID sin codificar */
+    unsigned char uuid1[16] = {0}, uuid2[16] = {0};
+    uuid1[15] = 1;
+    uuid2[15] = 2;
+    int valor1 = 1, valor2 = 2;
+
+    print_test("Prueba hash guardar_bin primer uuid", hash_guardar_bin(hash, uuid1, sizeof(uuid1), &valor1));
+    print_test("Prueba hash guardar_bin segundo uuid", hash_guardar_bin(hash, uuid2, sizeof(uuid2), &valor2));
+    print_test("Prueba hash la cantidad de elementos es 2", hash_cantidad(hash) == 2);
+    print_test("Prueba hash obtener_bin primer uuid", hash_obtener_bin(hash, uuid1, sizeof(uuid1)) == &valor1);
+    print_test("Prueba hash obtener_bin segundo uuid", hash_obtener_bin(hash, uuid2, sizeof(uuid2)) == &valor2);
+    print_test("Prueba hash un prefijo del uuid no pertenece", !hash_pertenece_bin(hash, uuid1, 15));
+
+    /* La cadena y los bytes sin '\0' son la misma clave */
+    print_test("Prueba hash guardar_bin sin el \\0", hash_guardar_bin(hash, "clave-sin-fin", 5, &valor1));
+    print_test("Prueba hash obtener como cadena", hash_obtener(hash, "clave") == &valor1);
+    print_test("Prueba hash calcular_bin coincide con calcular", hash_calcular_bin(hash, "clave", 5) == hash_calcular(hash, "clave"));
+
+    hash_iter_t* iter = hash_iter_crear(hash);
+    bool ok = true;
+    size_t recorridos = 0;
+    while (!hash_iter_al_final(iter)){
+        size_t largo_actual;
+        const void* clave = hash_iter_ver_actual_bin(iter, &largo_actual);
+        ok &= hash_pertenece_bin(hash, clave, largo_actual);
+        recorridos++;
+        hash_iter_avanzar(iter);
+    }
+    hash_iter_destruir(iter);
+    print_test("Prueba hash iterar devuelve el largo de cada clave", ok && recorridos == 3);
+
+    print_test("Prueba hash borrar_bin primer uuid", hash_borrar_bin(hash, uuid1, sizeof(uuid1)) == &valor1);
+    print_test("Prueba hash el segundo uuid sigue", hash_pertenece_bin(hash, uuid2, sizeof(uuid2)));
+
+    /* Muchas claves binarias de 8 bytes, con todos los bytes posibles */
+    ok = true;
+    for (uint64_t i = 0; i < largo; i++){
+        uint64_t clave = i * 0x0101010101010101ULL;
+        ok &= hash_guardar_bin(hash, &clave, sizeof(clave), NULL);
+    }
+    print_test("Prueba hash guardar_bin muchas claves", ok && hash_cantidad(hash) == largo + 2);
+    for (uint64_t i = 0; i < largo; i++){
+        uint64_t clave = i * 0x0101010101010101ULL;
+        bool insertado;
+        ok &= hash_obtener_o_insertar_bin(hash, &clave, sizeof(clave), &insertado) && !insertado;
+        ok &= hash_borrar_bin(hash, &clave, sizeof(clave)) == NULL;
+        ok &= !hash_pertenece_bin(hash, &clave, sizeof(clave));
+    }
+    print_test("Prueba hash borrar_bin muchas claves", ok && hash_cantidad(hash) == 2);
+
+    hash_destruir(hash);
+}
+
+static void prueba_hash_redimension_paralela(size_t largo, hash_motor_t motor)
+{
+    pool_t* pool = pool_crear(4);
+    hash_opciones_t opciones = { .pool = pool, .motor = motor };
+    hash_t* hash = hash_crear_con_opciones(&opciones);
+
+    /* Pasa varias veces por el mínimo para redimensionar en paralelo */
+    char (*claves)[10] = malloc(largo * 10);
+    bool ok = true;
+    for (size_t i = 0; i < largo; i++){
+        sprintf(claves[i], "%08zu", i);
+        ok &= hash_guardar(hash, claves[i], claves[i]);
+    }
+    print_test("Prueba hash guardar con redimension paralela", ok && hash_cantidad(hash) == largo);
+
+    for (size_t i = 0; i < largo; i++) ok &= hash_obtener(hash, claves[i]) == claves[i];
+    print_test("Prueba hash obtener despues de redimensionar en paralelo", ok);
+
+    for (size_t i = 0; i < largo; i += 2) ok &= hash_borrar(hash, claves[i]) == claves[i];
+    for (size_t i = 0; i < largo; i++) ok &= hash_pertenece(hash, claves[i]) == (i % 2 == 1);
+    print_test("Prueba hash borrar despues de redimensionar en paralelo", ok && hash_cantidad(hash) == largo / 2);
+
+    /* Reservar mucho más también reubica en paralelo */
+    print_test("Prueba hash reservar en paralelo", hash_reservar(hash, largo * 4));
+    for (size_t i = 1; i < largo; i += 2) ok &= hash_obtener(hash, claves[i]) == claves[i];
+    print_test("Prueba hash obtener despues de reservar en paralelo", ok && contar_iterando(hash) == largo / 2);
+
+    free(claves);
+    hash_destruir(hash);
+    pool_destruir(pool);
+}
+
+static void prueba_hash_construir(size_t largo, bool con_pool, bool arena)
+{
+    pool_t* pool = con_pool ? pool_crear(4) : NULL;
+    hash_opciones_t opciones = { .destruir_dato = free, .pool = pool, .arena_claves = arena };
+
+    /* Cada clave aparece dos veces: queda el dato de la última */
+    size_t distintas = largo / 2;
+    char (*texto)[10] = malloc(largo * 10);
+    const char** claves = malloc(largo * sizeof(char*));
+    void** datos = malloc(largo * sizeof(void*));
+    for (size_t i = 0; i < largo; i++){
+        sprintf(texto[i], "%08zu", (i * 7919) % distintas);
+        claves[i] = texto[i];
+        size_t* dato = malloc(sizeof(size_t));
+        *dato = i;
+        datos[i] = dato;
+    }
+
+    hash_t* hash = hash_construir(&opciones, claves, datos, largo);
+    print_test("Prueba hash construir", hash);
+    print_test("Prueba hash construir la cantidad no cuenta repetidas", hash_cantidad(hash) == distintas);
+
+    bool ok = true;
+    for (size_t i = distintas; i < largo; i++) ok &= hash_obtener(hash, claves[i]) == datos[i];
+    print_test("Prueba hash construir queda el ultimo dato de cada clave", ok);
+    print_test("Prueba hash construir se puede iterar", contar_iterando(hash) == distintas);
+
+    /* La tabla construida sigue funcionando como cualquier otra */
+    for (size_t i = distintas; i < largo; i += 2) free(hash_borrar(hash, claves[i]));
+    ok &= hash_guardar(hash, "otra", malloc(sizeof(size_t)));
+    for (size_t i = distintas + 1; i < largo; i += 2) ok &= hash_obtener(hash, claves[i]) == datos[i];
+    print_test("Prueba hash construir y despues modificar", ok && hash_cantidad(hash) == distintas / 2 + 1);
+
+    hash_destruir(hash);
+    free(datos);
+    free(claves);
+    free(texto);
+    if (pool) pool_destruir(pool);
+}
+
+// Guarda en el snapshot el número apuntado por el dato, o nada si es NULL.
+static const void *serializar_numero(void *dato, size_t *largo, void *extra)
+{
+    (void) extra;
+    *largo = dato ? sizeof(size_t) : 0;
+    return dato;
+}
+
+// Guarda el snapshot del hash en un archivo temporal y devuelve su ruta en
+// ruta, o false si no pudo.
+static bool guardar_en_temporal(hash_t *hash, char *ruta, hash_serializar_dato_t serializar)
+{
+    strcpy(ruta, "/tmp/hash_snapshot_XXXXXX");
+    int fd = mkstemp(ruta);
+    if (fd < 0) return false;
+    bool ok = hash_guardar_snapshot(hash, fd, serializar, NULL);
+    return close(fd) == 0 && ok;
+}
+
+static void prueba_hash_snapshot(size_t largo, hash_motor_t motor)
+{
+    hash_opciones_t opciones = { .destruir_dato = free, .motor = motor, .redimension_incremental = true };
+    hash_t* hash = hash_crear_con_opciones(&opciones);
+
+    /* Claves cortas y largas, y una binaria con '\0' en el medio */
+    char clave[40];
+    bool ok = true;
+    for (size_t i = 0; i < largo; i++){
+        size_t* dato = malloc(sizeof(size_t));
+        *dato = i;
+        sprintf(clave, i % 2 ? "%zu" : "una clave bastante larga %zu", i);
+        ok &= hash_guardar(hash, clave, dato);
+    }
+    size_t* binario = malloc(sizeof(size_t));
+    *binario = largo;
+    ok &= hash_guardar_bin(hash, "a\0b", 3, binario);
+
+    char ruta[32];
+    print_test("Prueba hash snapshot guardar", ok && guardar_en_temporal(hash, ruta, serializar_numero));
+    hash_t* abierto = hash_abrir_snapshot(ruta, NULL);
+    print_test("Prueba hash snapshot abrir", abierto);
+    print_test("Prueba hash snapshot la cantidad es la misma", hash_cantidad(abierto) == largo + 1);
+
+    for (size_t i = 0; i < largo; i++){
+        sprintf(clave, i % 2 ? "%zu" : "una clave bastante larga %zu", i);
+        const size_t* dato = hash_obtener(abierto, clave);
+        ok &= dato && *dato == i && hash_pertenece(abierto, clave);
+    }
+    print_test("Prueba hash snapshot obtener todas las claves", ok);
+    const size_t* dato = hash_obtener_bin(abierto, "a\0b", 3);
+    print_test("Prueba hash snapshot obtener clave binaria", dato && *dato == largo && !hash_pertenece(abierto, "a"));
+    print_test("Prueba hash snapshot clave inexistente", !hash_obtener(abierto, "no esta") && !hash_pertenece(abierto, ""));
+
+    size_t recorridas = 0;
+    hash_iter_t* iter = hash_iter_crear(abierto);
+    for (; !hash_iter_al_final(iter); hash_iter_avanzar(iter), recorridas++){
+        size_t largo_clave;
+        const void* actual = hash_iter_ver_actual_bin(iter, &largo_clave);
+        ok &= hash_obtener_bin(hash, actual, largo_clave) != NULL;
+    }
+    hash_iter_destruir(iter);
+    print_test("Prueba hash snapshot iterar", ok && recorridas == largo + 1);
+
+    /* Es de sólo lectura */
+    bool insertado;
+    ok = !hash_guardar(abierto, "nueva", NULL) && !hash_borrar(abierto, "1") && !hash_reservar(abierto, largo * 2);
+    ok &= !hash_obtener_o_insertar(abierto, "nueva", &insertado) && hash_cantidad(abierto) == largo + 1;
+    print_test("Prueba hash snapshot no se puede modificar", ok && hash_pertenece(abierto, "1"));
+
+    /* Un snapshot de un snapshot es la misma imagen */
+    char otra[32];
+    ok = guardar_en_temporal(abierto, otra, NULL);
+    hash_t* copia = hash_abrir_snapshot(otra, NULL);
+    dato = hash_obtener(copia, "1");
+    print_test("Prueba hash snapshot de un snapshot", ok && copia && dato && *dato == 1);
+    hash_destruir(copia);
+    unlink(otra);
+
+    print_test("Prueba hash snapshot con otra funcion de hash es NULL", !hash_abrir_snapshot(ruta, hash_constante));
+    print_test("Prueba hash snapshot de un archivo que no existe es NULL", !hash_abrir_snapshot("/tmp/no/existe", NULL));
+
+    /* Un archivo cortado o con las ranuras pisadas no se abre */
+    char cortado[32];
+    ok = guardar_en_temporal(hash, cortado, serializar_numero);
+    ok &= truncate(cortado, 4096) == 0;
+    print_test("Prueba hash snapshot de un archivo cortado es NULL", ok && !hash_abrir_snapshot(cortado, NULL));
+    unlink(cortado);
+
+    char pisado[32];
+    ok = guardar_en_temporal(hash, pisado, serializar_numero);
+    FILE* archivo = fopen(pisado, "r+b");
+    // Deja el encabezado de 64 bytes y pisa los desplazamientos de las ranuras
+    ok &= archivo && fseek(archivo, 64, SEEK_SET) == 0;
+    for (size_t i = 0; ok && i < 4096; i++) ok &= fputc(0xff, archivo) != EOF;
+    if (archivo) ok &= fclose(archivo) == 0;
+    print_test("Prueba hash snapshot con ranuras corruptas es NULL", ok && !hash_abrir_snapshot(pisado, NULL));
+    unlink(pisado);
+
+    hash_destruir(abierto);
+    unlink(ruta);
+    hash_destruir(hash);
+}
+
+static void prueba_hash_cursor(size_t largo, bool incremental)
+{
+    hash_opciones_t opciones = { .redimension_incremental = incremental };
+    hash_t* hash = hash_crear_con_opciones(&opciones);
+
+    hash_cursor_t cursor;
+    hash_cursor_iniciar(&cursor, hash);
+    print_test("Prueba hash cursor en hash vacio no avanza", !hash_cursor_avanzar(&cursor) && !cursor.clave);
+
+    /* Quedan pocas claves desparramadas en una tabla grande */
+    char (*claves)[10] = malloc(largo * 10);
+    for (size_t i = 0; i < largo; i++){
+        sprintf(claves[i], "%08zu", i);
+        hash_guardar(hash, claves[i], claves[i]);
+    }
+    hash_cambiar_politica(hash, &(hash_politica_t) { .carga_maxima = 0.7, .reducir = false });
+    for (size_t i = 0; i < largo; i++){
+        if (i % 50) hash_borrar(hash, claves[i]);
+    }
+
+    size_t recorridos = 0;
+    bool ok = true;
+    hash_cursor_iniciar(&cursor, hash);
+    while (hash_cursor_avanzar(&cursor)){
+        ok &= cursor.dato == hash_obtener(hash, cursor.clave) && strlen(cursor.clave) == cursor.largo;
+        ok &= cursor.hash == hash_calcular(hash, cursor.clave);
+        recorridos++;
+    }
+    print_test("Prueba hash cursor da clave, dato y hash", ok);
+    print_test("Prueba hash cursor recorre todos los elementos", recorridos == hash_cantidad(hash));
+    print_test("Prueba hash cursor al final sigue sin avanzar", !hash_cursor_avanzar(&cursor));
+
+    /* El iterador también da el dato */
+    hash_iter_t* iter = hash_iter_crear(hash);
+    for (recorridos = 0; !hash_iter_al_final(iter); hash_iter_avanzar(iter), recorridos++){
+        ok &= hash_iter_ver_dato(iter) == hash_obtener(hash, hash_iter_ver_actual(iter));
+    }
+    print_test("Prueba hash iterador ver dato", ok && recorridos == hash_cantidad(hash) && !hash_iter_ver_dato(iter));
+    hash_iter_destruir(iter);
+
+    free(claves);
+    hash_destruir(hash);
+}
+
+static void prueba_hash_compacto(size_t largo)
+{
+    hash_opciones_t opciones = { .destruir_dato = free, .compacto = true };
+    hash_t* hash = hash_crear_con_opciones(&opciones);
+    print_test("Prueba hash compacto crear", hash);
+
+    char clave[24];
+    bool ok = true;
+    for (size_t i = 0; i < largo; i++){
+        size_t* dato = malloc(sizeof(size_t));
+        *dato = i;
+        sprintf(clave, "%zu", i);
+        ok &= hash_guardar(hash, clave, dato);
+    }
+    print_test("Prueba hash compacto guardar muchos elementos", ok && hash_cantidad(hash) == largo);
+    for (size_t i = 0; i < largo; i++){
+        sprintf(clave, "%zu", i);
+        const size_t* dato = hash_obtener(hash, clave);
+        ok &= dato && *dato == i;
+    }
+    print_test("Prueba hash compacto obtener todos", ok && !hash_pertenece(hash, "no esta"));
+
+    /* Se borran los pares y se reemplaza el dato de los múltiplos de 3 */
+    for (size_t i = 0; i < largo; i += 2){
+        sprintf(clave, "%zu", i);
+        free(hash_borrar(hash, clave));
+    }
+    for (size_t i = 3; i < largo; i += 6){
+        size_t* dato = malloc(sizeof(size_t));
+        *dato = i;
+        sprintf(clave, "%zu", i);
+        ok &= hash_guardar(hash, clave, dato);
+    }
+    print_test("Prueba hash compacto borrar y reemplazar", ok && hash_cantidad(hash) == largo / 2);
+
+    /* Los que se vuelven a guardar van al final: los datos quedan en orden */
+    for (size_t i = 0; i < largo; i += 2){
+        size_t* dato = malloc(sizeof(size_t));
+        *dato = largo + i;
+        sprintf(clave, "%zu", i);
+        ok &= hash_guardar(hash, clave, dato);
+    }
+    print_test("Prueba hash compacto guardar de nuevo los borrados", ok && hash_cantidad(hash) == largo);
+
+    size_t anterior = 0, recorridos = 0;
+    hash_iter_t* iter = hash_iter_crear(hash);
+    for (; !hash_iter_al_final(iter); hash_iter_avanzar(iter), recorridos++){
+        const size_t* dato = hash_iter_ver_dato(iter);
+        ok &= recorridos == 0 || *dato > anterior;
+        anterior = *dato;
+        ok &= hash_obtener(hash, hash_iter_ver_actual(iter)) == dato;
+    }
+    hash_iter_destruir(iter);
+    print_test("Prueba hash compacto el iterador sigue el orden de insercion", ok && recorridos == largo);
+
+    hash_cursor_t cursor;
+    hash_cursor_iniciar(&cursor, hash);
+    for (recorridos = 0; hash_cursor_avanzar(&cursor); recorridos++){
+        ok &= cursor.hash == hash_calcular(hash, cursor.clave) && hash_obtener(hash, cursor.clave) == cursor.dato;
+    }
+    print_test("Prueba hash compacto cursor", ok && recorridos == largo);
+
+    bool insertado;
+    void** lugar = hash_obtener_o_insertar(hash, "nueva", &insertado);
+    ok = lugar && insertado && !*lugar;
+    if (lugar) *lugar = malloc(sizeof(size_t));
+    lugar = hash_obtener_o_insertar(hash, "nueva", &insertado);
+    print_test("Prueba hash compacto obtener o insertar", ok && lugar && !insertado && *lugar);
+    free(hash_borrar(hash, "nueva"));
+
+    /* Un snapshot del hash compacto tiene las mismas claves */
+    char ruta[32];
+    print_test("Prueba hash compacto snapshot guardar", guardar_en_temporal(hash, ruta, serializar_numero));
+    hash_t* abierto = hash_abrir_snapshot(ruta, NULL);
+    ok = abierto && hash_cantidad(abierto) == largo;
+    for (size_t i = 0; ok && i < largo; i++){
+        sprintf(clave, "%zu", i);
+        ok &= *(const size_t*) hash_obtener(abierto, clave) == *(const size_t*) hash_obtener(hash, clave);
+    }
+    print_test("Prueba hash compacto snapshot abrir", ok);
+    if (abierto) hash_destruir(abierto);
+    unlink(ruta);
+    hash_destruir(hash);
+
+    /* reservar y guardar_lote */
+    hash = hash_crear_con_opciones(&(hash_opciones_t) { .compacto = true });
+    char (*texto)[10] = malloc(largo * 10);
+    const char** claves = malloc(largo * sizeof(char*));
+    for (size_t i = 0; i < largo; i++){
+        sprintf(texto[i], "%08zu", i);
+        claves[i] = texto[i];
+    }
+    ok = hash_reservar(hash, largo) && hash_guardar_lote(hash, claves, (void**) claves, largo);
+    size_t i = 0;
+    iter = hash_iter_crear(hash);
+    for (; ok && !hash_iter_al_final(iter); hash_iter_avanzar(iter), i++){
+        ok &= hash_iter_ver_dato(iter) == claves[i];
+    }
+    hash_iter_destruir(iter);
+    print_test("Prueba hash compacto reservar y guardar lote en orden", ok && i == largo);
+
+    /* Con el arreglo de entradas lleno, las borradas siguen ocupando lugar
+     * hasta juntar las vivas: el lote tiene que dejar lugar igual */
+    for (i = 0; i < largo / 2; i++) hash_borrar(hash, claves[i]);
+    ok = hash_guardar_lote(hash, claves, (void**) claves, largo / 2) && hash_cantidad(hash) == largo;
+    for (i = 0; ok && i < largo; i++) ok &= hash_obtener(hash, claves[i]) == claves[i];
+    print_test("Prueba hash compacto guardar lote despues de borrar", ok);
+    free(claves);
+    free(texto);
+    hash_destruir(hash);
+
+    opciones = (hash_opciones_t) { .compacto = true, .motor = HASH_MOTOR_GRUPOS };
+    print_test("Prueba hash compacto con motor de grupos es NULL", !hash_crear_con_opciones(&opciones));
+    opciones = (hash_opciones_t) { .compacto = true, .redimension_incremental = true };
+    print_test("Prueba hash compacto con redimension incremental es NULL", !hash_crear_con_opciones(&opciones));
+}
+
+// Recorre el hash borrando con el iterador los elementos cuyo dato da resto
+// módulo 3. Devuelve la cantidad de borrados, o 0 si algo salió mal.
+static size_t borrar_con_iterador(hash_t *hash, size_t resto, hash_iter_t **iter)
+{
+    size_t visitados = hash_cantidad(hash), borrados = 0;
+    bool ok = true;
+    *iter = hash_iter_crear(hash);
+    while (!hash_iter_al_final(*iter)){
+        size_t* dato = hash_iter_ver_dato(*iter);
+        visitados--;
+        if (*dato % 3 != resto){
+            hash_iter_avanzar(*iter);
+            continue;
+        }
+        ok &= hash_iter_borrar_actual(*iter) == dato;
+        free(dato);
+        borrados++;
+    }
+    return ok && visitados == 0 ? borrados : 0;
+}
+
+static void prueba_hash_iter_borrar(size_t largo, hash_opciones_t opciones)
+{
+    hash_t* hash = hash_crear_con_opciones(&opciones);
+    char clave[24];
+    for (size_t i = 0; i < largo; i++){
+        size_t* dato = malloc(sizeof(size_t));
+        *dato = i;
+        sprintf(clave, "%zu", i);
+        hash_guardar(hash, clave, dato);
+    }
+
+    /* Filtrado en una pasada: el iterador visita cada elemento una vez */
+    hash_iter_t* otro = hash_iter_crear(hash);
+    hash_iter_t* iter;
+    size_t borrados = borrar_con_iterador(hash, 0, &iter);
+    print_test("Prueba hash iter borrar actual visita todos una vez", borrados == (largo + 2) / 3);
+    print_test("Prueba hash iter borrar actual al final devuelve NULL", !hash_iter_borrar_actual(iter));
+    print_test("Prueba hash iter borrar actual la cantidad baja", hash_cantidad(hash) == largo - borrados);
+
+    bool ok = true;
+    for (size_t i = 0; i < largo; i++){
+        sprintf(clave, "%zu", i);
+        const size_t* dato = hash_obtener(hash, clave);
+        ok &= i % 3 ? dato && *dato == i : !dato && !hash_pertenece(hash, clave);
+    }
+    print_test("Prueba hash iter borrar actual antes de compactar", ok);
+
+    print_test("Prueba hash iter borrar actual invalida a los otros", !hash_iter_valido(otro) && hash_iter_al_final(otro));
+    print_test("Prueba hash iter borrar actual el que borra sigue valido", hash_iter_valido(iter));
+    hash_iter_destruir(otro);
+    hash_iter_destruir(iter);
+
+    /* Otra pasada, y una modificación compacta antes de destruir el iterador */
+    borrados += borrar_con_iterador(hash, 1, &iter);
+    size_t* dato = malloc(sizeof(size_t));
+    *dato = largo;
+    ok = hash_guardar(hash, "nueva", dato);
+    print_test("Prueba hash iter modificar el hash invalida el iterador", ok && !hash_iter_valido(iter) && hash_iter_al_final(iter));
+    print_test("Prueba hash iter invalido no avanza ni borra", !hash_iter_avanzar(iter) && !hash_iter_ver_actual(iter) && !hash_iter_borrar_actual(iter));
+    hash_iter_destruir(iter);
+
+    for (size_t i = 0; i < largo; i++){
+        sprintf(clave, "%zu", i);
+        const size_t* guardado = hash_obtener(hash, clave);
+        ok &= i % 3 == 2 ? guardado && *guardado == i : !guardado;
+    }
+    print_test("Prueba hash iter borrar actual despues de compactar", ok && hash_cantidad(hash) == largo + 1 - borrados);
+
+    size_t recorridos = 0;
+    iter = hash_iter_crear(hash);
+    for (; !hash_iter_al_final(iter); hash_iter_avanzar(iter)) recorridos++;
+    hash_iter_destruir(iter);
+    print_test("Prueba hash iter despues de compactar recorre todos", recorridos == hash_cantidad(hash));
+    hash_destruir(hash);
+}
+
+// Reemplaza datos de claves que ya están con una carga máxima que hace
+// agrandar la tabla ante cualquier clave nueva: el iterador sigue valido.
+static void prueba_hash_iter_reemplazar(size_t largo, hash_opciones_t opciones)
+{
+    hash_t* hash = hash_crear_con_opciones(&opciones);
+    char clave[24];
+    bool ok = true;
+    for (size_t i = 0; i < largo; i++){
+        sprintf(clave, "%zu", i);
+        ok &= hash_guardar(hash, clave, (void*) i);
+    }
+    hash_politica_t politica = hash_politica_por_defecto();
+    politica.carga_maxima = 0.01;
+    politica.carga_minima = 0;
+    politica.histeresis = 0;
+    ok &= hash_cambiar_politica(hash, &politica);
+
+    hash_iter_t* iter = hash_iter_crear(hash);
+    size_t posiciones = hash_iter_posiciones(hash);
+    for (size_t i = 0; i < largo; i++){
+        sprintf(clave, "%zu", i);
+        bool insertado = true;
+        size_t insertadas = 0;
+        ok &= hash_guardar(hash, clave, (void*) (i + 1));
+        void** dato = hash_obtener_o_insertar(hash, clave, &insertado);
+        ok &= dato && !insertado && *dato == (void*) (i + 1);
+        ok &= hash_actualizar(hash, clave, sumar_uno, &insertadas) && !insertadas;
+    }
+    print_test("Prueba hash iter reemplazar en el limite de carga no redimensiona", ok && hash_iter_posiciones(hash) == posiciones);
+    print_test("Prueba hash iter reemplazar en el limite de carga sigue valido", hash_iter_valido(iter) && !hash_iter_al_final(iter));
+
+    size_t recorridos = 0;
+    for (; !hash_iter_al_final(iter); hash_iter_avanzar(iter), recorridos++){
+        const char* actual = hash_iter_ver_actual(iter);
+        ok &= (size_t) hash_iter_ver_dato(iter) == strtoul(actual, NULL, 10) + 2;
+    }
+    print_test("Prueba hash iter reemplazar recorre los datos nuevos", ok && recorridos == largo);
+    hash_iter_destruir(iter);
+
+    /* Una clave nueva sí agranda la tabla e invalida el iterador */
+    iter = hash_iter_crear(hash);
+    ok = hash_guardar(hash, "nueva", NULL);
+    print_test("Prueba hash iter guardar clave nueva en el limite invalida", ok && !hash_iter_valido(iter));
+    hash_iter_destruir(iter);
+    hash_destruir(hash);
+}
+
+#define PARTES 16
+
+typedef struct suma_por_parte {
+    size_t suma[PARTES];
+    size_t cantidad[PARTES];
+    bool ok;
+} suma_por_parte_t;
+
+static void sumar_elemento(const hash_cursor_t *elemento, size_t parte, void *extra)
+{
+    suma_por_parte_t* s = extra;
+    s->suma[parte] += *(const size_t*) elemento->dato;
+    s->cantidad[parte]++;
+    if (elemento->largo != strlen(elemento->clave)) s->ok = false;
+}
+
+// Suma los datos con hash_para_cada_paralelo y compara con la suma esperada.
+static bool sumar_en_paralelo(const hash_t *hash, pool_t *pool, size_t esperada)
+{
+    suma_por_parte_t s = { .ok = true };
+    hash_para_cada_paralelo(hash, pool, PARTES, sumar_elemento, &s);
+    size_t suma = 0, cantidad = 0;
+    for (size_t i = 0; i < PARTES; i++){
+        suma += s.suma[i];
+        cantidad += s.cantidad[i];
+    }
+    return s.ok && suma == esperada && cantidad == hash_cantidad(hash);
+}
+
+static void prueba_hash_recorrer_en_paralelo(size_t largo, hash_opciones_t opciones)
+{
+    pool_t* pool = pool_crear(4);
+    hash_t* hash = hash_crear_con_opciones(&opciones);
+    char clave[24];
+    size_t* datos = malloc(largo * sizeof(size_t));
+    size_t esperada = 0;
+    for (size_t i = 0; i < largo; i++){
+        datos[i] = i;
+        sprintf(clave, "%zu", i);
+        hash_guardar(hash, clave, &datos[i]);
+        if (i % 5) esperada += i;
+    }
+    for (size_t i = 0; i < largo; i += 5){
+        sprintf(clave, "%zu", i);
+        hash_borrar(hash, clave);
+    }
+
+    print_test("Prueba hash para cada paralelo con pool", sumar_en_paralelo(hash, pool, esperada));
+    print_test("Prueba hash para cada paralelo sin pool", sumar_en_paralelo(hash, NULL, esperada));
+
+    /* Tres rangos que cubren todas las posiciones, más uno vacío */
+    size_t posiciones = hash_iter_posiciones(hash);
+    size_t cortes[] = {0, posiciones / 3, posiciones / 2, posiciones + 10};
+    size_t recorridos = 0, suma = 0;
+    for (size_t r = 0; r < 3; r++){
+        hash_iter_t* iter = hash_iter_crear_rango(hash, cortes[r], cortes[r + 1]);
+        for (; !hash_iter_al_final(iter); hash_iter_avanzar(iter), recorridos++){
+            suma += *(const size_t*) hash_iter_ver_dato(iter);
+        }
+        hash_iter_destruir(iter);
+    }
+    print_test("Prueba hash iterar por rangos recorre todos", recorridos == hash_cantidad(hash) && suma == esperada);
+    hash_iter_t* iter = hash_iter_crear_rango(hash, posiciones, posiciones);
+    print_test("Prueba hash iterar rango vacio esta al final", hash_iter_al_final(iter));
+    hash_iter_destruir(iter);
+
+    hash_destruir(hash);
+    pool_destruir(pool);
+    free(datos);
+}
+
+#define LARGO_CLAVE_LOTE 40
+
+// Busca con hash_obtener_lote las claves de 0 a 2 * largo: las pares están
+// en el hash con su número de dato, y la 0 con dato NULL.
+static bool comprobar_obtener_lote(const hash_t *hash, size_t largo, bool datos_en_bytes)
+{
+    size_t n = 2 * largo;
+    char (*texto)[LARGO_CLAVE_LOTE] = malloc(n * LARGO_CLAVE_LOTE);
+    const char** claves = malloc(n * sizeof(char*));
+    void** resultados = malloc(n * sizeof(void*));
+    for (size_t i = 0; i < n; i++){
+        sprintf(texto[i], i % 4 ? "%zu" : "una clave larga para el lote %zu", i);
+        claves[i] = texto[i];
+    }
+
+    bool ok = hash_obtener_lote(hash, claves, n, resultados) == (n + 1) / 2;
+    for (size_t i = 0; i < n; i++){
+        if (i % 2 == 1){
+            ok &= !resultados[i];
+        } else if (datos_en_bytes){
+            ok &= resultados[i] && (i == 0 || *(const size_t*) resultados[i] == i);
+        } else {
+            ok &= resultados[i] == hash_obtener(hash, claves[i]) && (i == 0 || *(const size_t*) resultados[i] == i);
+        }
+    }
+    free(resultados);
+    free(claves);
+    free(texto);
+    return ok;
+}
+
+static void prueba_hash_obtener_lote(size_t largo, hash_opciones_t opciones)
+{
+    hash_t* hash = hash_crear_con_opciones(&opciones);
+    print_test("Prueba hash obtener lote vacio", hash_obtener_lote(hash, NULL, 0, NULL) == 0);
+
+    size_t* datos = malloc(2 * largo * sizeof(size_t));
+    char clave[LARGO_CLAVE_LOTE];
+    for (size_t i = 0; i < 2 * largo; i += 2){
+        datos[i] = i;
+        sprintf(clave, i % 4 ? "%zu" : "una clave larga para el lote %zu", i);
+        hash_guardar(hash, clave, i ? &datos[i] : NULL);
+    }
+    print_test("Prueba hash obtener lote", comprobar_obtener_lote(hash, largo, false));
+
+    /* También sobre un snapshot del mismo hash */
+    char ruta[32];
+    bool ok = guardar_en_temporal(hash, ruta, serializar_numero);
+    hash_t* abierto = ok ? hash_abrir_snapshot(ruta, NULL) : NULL;
+    print_test("Prueba hash obtener lote en snapshot", abierto && comprobar_obtener_lote(abierto, largo, true));
+    if (abierto) hash_destruir(abierto);
+    unlink(ruta);
+
+    hash_destruir(hash);
+    free(datos);
+}
+
 /* ******************************************************************
  *                        FUNCIÓN PRINCIPAL
  * *****************************************************************/
@@ -411,9 +1528,266 @@ void pruebas_hash_catedra()
     prueba_hash_volumen(5000, true);
     prueba_hash_iterar();
     prueba_hash_iterar_volumen(5000);
+    prueba_hash_funcion_propia();
+    prueba_hash_funcion_rapida();
+    prueba_hash_borrar_e_insertar_alternado(5000);
+    prueba_hash_motor_grupos(5000, NULL);
+    prueba_hash_motor_grupos(100, hash_constante);
+    prueba_hash_arena_claves(2000);
+    prueba_hash_claves_de_todos_los_largos();
+    prueba_hash_redimension_incremental(5000, HASH_MOTOR_LINEAL);
+    prueba_hash_redimension_incremental(5000, HASH_MOTOR_GRUPOS);
+    prueba_hash_reservar_y_guardar_lote(5000);
+    prueba_hash_politicas();
+    prueba_hash_contadores(5000);
+    prueba_hash_precalculado();
+    prueba_hash_claves_binarias(5000);
+    prueba_hash_redimension_paralela(60000, HASH_MOTOR_LINEAL);
+    prueba_hash_redimension_paralela(60000, HASH_MOTOR_GRUPOS);
+    prueba_hash_construir(40000, true, false);
+    prueba_hash_construir(40000, true, true);
+    prueba_hash_construir(1000, false, false);
+    prueba_hash_snapshot(5000, HASH_MOTOR_LINEAL);
+    prueba_hash_snapshot(5000, HASH_MOTOR_GRUPOS);
+    prueba_hash_cursor(5000, false);
+    prueba_hash_cursor(5000, true);
+    prueba_hash_compacto(5000);
+    prueba_hash_iter_borrar(5000, (hash_opciones_t) { .destruir_dato = free });
+    prueba_hash_iter_borrar(5000, (hash_opciones_t) { .destruir_dato = free, .motor = HASH_MOTOR_GRUPOS });
+    prueba_hash_iter_borrar(5000, (hash_opciones_t) { .destruir_dato = free, .redimension_incremental = true });
+    prueba_hash_iter_borrar(5000, (hash_opciones_t) { .destruir_dato = free, .compacto = true });
+    prueba_hash_iter_reemplazar(1000, (hash_opciones_t) { 0 });
+    prueba_hash_iter_reemplazar(1000, (hash_opciones_t) { .motor = HASH_MOTOR_GRUPOS });
+    prueba_hash_iter_reemplazar(1000, (hash_opciones_t) { .redimension_incremental = true });
+    prueba_hash_iter_reemplazar(1000, (hash_opciones_t) { .compacto = true });
+    prueba_hash_recorrer_en_paralelo(20000, (hash_opciones_t) {0});
+    prueba_hash_recorrer_en_paralelo(20000, (hash_opciones_t) { .redimension_incremental = true });
+    prueba_hash_recorrer_en_paralelo(20000, (hash_opciones_t) { .compacto = true });
+    prueba_hash_obtener_lote(5000, (hash_opciones_t) {0});
+    prueba_hash_obtener_lote(5000, (hash_opciones_t) { .motor = HASH_MOTOR_GRUPOS });
+    prueba_hash_obtener_lote(5000, (hash_opciones_t) { .redimension_incremental = true });
+    prueba_hash_obtener_lote(5000, (hash_opciones_t) { .compacto = true });
 }
 
 void pruebas_volumen_catedra(size_t largo)
 {
     prueba_hash_volumen(largo, false);
 }
+
+static double segundos_desde(const struct timespec *inicio)
+{
+    struct timespec fin;
+    clock_gettime(CLOCK_MONOTONIC, &fin);
+    return (double) (fin.tv_sec - inicio->tv_sec) + (double) (fin.tv_nsec - inicio->tv_nsec) / 1e9;
+}
+
+// Compara armar un hash con hash_guardar_lote y con hash_construir usando un
+// pool con un hilo por procesador.
+void pruebas_volumen_construir(size_t largo)
+{
+    char (*texto)[10] = malloc(largo * 10);
+    const char** claves = malloc(largo * sizeof(char*));
+    for (size_t i = 0; i < largo; i++){
+        sprintf(texto[i], "%08zu", i);
+        claves[i] = texto[i];
+    }
+
+    long procesadores = sysconf(_SC_NPROCESSORS_ONLN);
+    pool_t* pool = pool_crear(procesadores > 0 ? (size_t) procesadores : 1);
+    hash_opciones_t opciones = { .pool = pool };
+
+    struct timespec inicio;
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    hash_t* hash = hash_crear(NULL);
+    hash_guardar_lote(hash, claves, (void**) claves, largo);
+    printf("guardar_lote: %.3fs - ", segundos_desde(&inicio));
+    hash_destruir(hash);
+
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    hash = hash_construir(&opciones, claves, (void**) claves, largo);
+    printf("construir con %zu hilos: %.3fs\n", pool_hilos(pool), segundos_desde(&inicio));
+    hash_destruir(hash);
+
+    pool_destruir(pool);
+    free(claves);
+    free(texto);
+}
+
+// Compara armar el hash con hash_guardar_lote con abrir un snapshot suyo y
+// buscar todas las claves.
+void pruebas_volumen_snapshot(size_t largo)
+{
+    char (*texto)[10] = malloc(largo * 10);
+    const char** claves = malloc(largo * sizeof(char*));
+    for (size_t i = 0; i < largo; i++){
+        sprintf(texto[i], "%08zu", i);
+        claves[i] = texto[i];
+    }
+
+    struct timespec inicio;
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    hash_t* hash = hash_crear(NULL);
+    hash_guardar_lote(hash, claves, (void**) claves, largo);
+    printf("guardar_lote: %.3fs - ", segundos_desde(&inicio));
+
+    char ruta[32];
+    guardar_en_temporal(hash, ruta, NULL);
+    hash_destruir(hash);
+
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    hash = hash_abrir_snapshot(ruta, NULL);
+    printf("abrir snapshot: %.6fs - ", segundos_desde(&inicio));
+    bool ok = hash != NULL;
+    for (size_t i = 0; ok && i < largo; i++) ok &= hash_pertenece(hash, claves[i]);
+    printf("abrir y buscar todas: %.3fs\n", segundos_desde(&inicio));
+    print_test("Prueba hash snapshot volumen", ok);
+
+    if (hash) hash_destruir(hash);
+    unlink(ruta);
+    free(claves);
+    free(texto);
+}
+
+// Recorre un hash del que se borró el 99% de los elementos, con el iterador
+// y hash_obtener, y con el cursor.
+void pruebas_volumen_recorrer(size_t largo)
+{
+    char (*texto)[10] = malloc(largo * 10);
+    hash_t* hash = hash_crear(NULL);
+    hash_politica_t sin_reducir = { .carga_maxima = 0.7 };
+    hash_cambiar_politica(hash, &sin_reducir);
+    for (size_t i = 0; i < largo; i++){
+        sprintf(texto[i], "%08zu", i);
+        hash_guardar(hash, texto[i], texto[i]);
+    }
+    for (size_t i = 0; i < largo; i++){
+        if (i % 100) hash_borrar(hash, texto[i]);
+    }
+
+    struct timespec inicio;
+    size_t total = 0;
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    hash_iter_t* iter = hash_iter_crear(hash);
+    for (; !hash_iter_al_final(iter); hash_iter_avanzar(iter)){
+        total += hash_obtener(hash, hash_iter_ver_actual(iter)) != NULL;
+    }
+    hash_iter_destruir(iter);
+    printf("iterar y obtener: %.4fs - ", segundos_desde(&inicio));
+
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    hash_cursor_t cursor;
+    hash_cursor_iniciar(&cursor, hash);
+    while (hash_cursor_avanzar(&cursor)) total += cursor.dato != NULL;
+    printf("cursor: %.4fs\n", segundos_desde(&inicio));
+    print_test("Prueba hash recorrer volumen", total == 2 * hash_cantidad(hash));
+
+    hash_destruir(hash);
+    free(texto);
+}
+
+// Mide guardar, buscar y recorrer todas las claves en un hash con el diseño
+// de siempre y en uno compacto.
+void pruebas_volumen_compacto(size_t largo)
+{
+    char (*texto)[10] = malloc(largo * 10);
+    for (size_t i = 0; i < largo; i++) sprintf(texto[i], "%08zu", i);
+
+    bool ok = true;
+    for (int compacto = 0; compacto < 2; compacto++){
+        struct timespec inicio;
+        clock_gettime(CLOCK_MONOTONIC, &inicio);
+        hash_t* hash = hash_crear_con_opciones(&(hash_opciones_t) { .compacto = compacto });
+        for (size_t i = 0; i < largo; i++) ok &= hash_guardar(hash, texto[i], texto[i]);
+        printf("%s guardar: %.3fs - ", compacto ? "compacto" : "campos", segundos_desde(&inicio));
+
+        clock_gettime(CLOCK_MONOTONIC, &inicio);
+        for (size_t i = 0; i < largo; i++) ok &= hash_obtener(hash, texto[i]) == texto[i];
+        printf("obtener: %.3fs - ", segundos_desde(&inicio));
+
+        clock_gettime(CLOCK_MONOTONIC, &inicio);
+        size_t recorridos = 0;
+        hash_cursor_t cursor;
+        hash_cursor_iniciar(&cursor, hash);
+        while (hash_cursor_avanzar(&cursor)) recorridos += cursor.dato != NULL;
+        printf("recorrer: %.4fs%s", segundos_desde(&inicio), compacto ? "\n" : " - ");
+        ok &= recorridos == largo;
+        hash_destruir(hash);
+    }
+    print_test("Prueba hash compacto volumen", ok);
+    free(texto);
+}
+
+// Suma los datos de todos los elementos con un hilo y con un hilo por
+// procesador.
+void pruebas_volumen_paralelo(size_t largo)
+{
+    size_t* datos = malloc(largo * sizeof(size_t));
+    char clave[24];
+    hash_t* hash = hash_crear(NULL);
+    size_t esperada = 0;
+    for (size_t i = 0; i < largo; i++){
+        datos[i] = i;
+        esperada += i;
+        sprintf(clave, "%zu", i);
+        hash_guardar(hash, clave, &datos[i]);
+    }
+
+    long procesadores = sysconf(_SC_NPROCESSORS_ONLN);
+    pool_t* pool = pool_crear(procesadores > 0 ? (size_t) procesadores : 1);
+
+    struct timespec inicio;
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    bool ok = sumar_en_paralelo(hash, NULL, esperada);
+    printf("sumar con un hilo: %.4fs - ", segundos_desde(&inicio));
+
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    ok &= sumar_en_paralelo(hash, pool, esperada);
+    printf("con %zu hilos: %.4fs\n", pool_hilos(pool), segundos_desde(&inicio));
+    print_test("Prueba hash para cada paralelo volumen", ok);
+
+    pool_destruir(pool);
+    hash_destruir(hash);
+    free(datos);
+}
+
+// Busca todas las claves en orden desordenado con hash_obtener y con
+// hash_obtener_lote de a 1024.
+void pruebas_volumen_lote(size_t largo)
+{
+    char (*texto)[10] = malloc(largo * 10);
+    const char** claves = malloc(largo * sizeof(char*));
+    void** resultados = malloc(largo * sizeof(void*));
+    hash_t* hash = hash_crear(NULL);
+    for (size_t i = 0; i < largo; i++){
+        sprintf(texto[i], "%08zu", i);
+        hash_guardar(hash, texto[i], texto[i]);
+    }
+    // Orden aleatorio, para que no haya localidad entre búsquedas seguidas
+    for (size_t i = 0; i < largo; i++) claves[i] = texto[i];
+    for (size_t i = largo; i > 1; i--){
+        size_t j = (size_t) rand() % i;
+        const char* aux = claves[i - 1];
+        claves[i - 1] = claves[j];
+        claves[j] = aux;
+    }
+
+    struct timespec inicio;
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    bool ok = true;
+    for (size_t i = 0; i < largo; i++) ok &= hash_obtener(hash, claves[i]) == claves[i];
+    printf("obtener de a una: %.3fs - ", segundos_desde(&inicio));
+
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    for (size_t base = 0; base < largo; base += 1024){
+        size_t n = largo - base < 1024 ? largo - base : 1024;
+        ok &= hash_obtener_lote(hash, &claves[base], n, &resultados[base]) == n;
+    }
+    printf("de a lotes: %.3fs\n", segundos_desde(&inicio));
+    for (size_t i = 0; i < largo; i++) ok &= resultados[i] == claves[i];
+    print_test("Prueba hash obtener lote volumen", ok);
+
+    hash_destruir(hash);
+    free(resultados);
+    free(claves);
+    free(texto);
+}
@@ -0,0 +1,122 @@
+#include "hash_u64.h"
+#include "hash_generico.h"
+#include <stdlib.h>
+#include <stdint.h>
+
+// Constante de Fibonacci: 2^64 dividido la razón áurea, impar
+#define MULTIPLICADOR 0x9e3779b97f4a7c15ULL
+
+/* ******************************************************************
+ *                        STRUCT HASH
+ * *****************************************************************/
+
+/* Multiplicación por la constante de Fibonacci, plegando la mitad alta sobre
+ * la baja para que los bits bajos, de los que sale la posición, dependan de
+ * toda la clave. */
+static inline uint64_t mezclar(uint64_t clave){
+    uint64_t h = clave * MULTIPLICADOR;
+    return h ^ (h >> 32);
+}
+
+static inline bool iguales(uint64_t a, uint64_t b){
+    return a == b;
+}
+
+HASH_DEFINE(tabla_u64, uint64_t, void*, mezclar, iguales)
+
+/* hash_u64_t es el hash generado para claves uint64_t y datos void*, más la
+ * función para destruir los datos. */
+struct hash_u64 {
+	tabla_u64_t* tabla;
+	hash_u64_destruir_dato_t destruir_dato;
+};
+
+struct hash_u64_iter {
+	tabla_u64_iter_t iter;
+};
+
+/* ******************************************************************
+ *                        PRIMITIVAS HASH
+ * *****************************************************************/
+
+hash_u64_t *hash_u64_crear(hash_u64_destruir_dato_t destruir_dato){
+
+    hash_u64_t* hash = malloc(sizeof(hash_u64_t));
+    if(!hash) return NULL;
+
+    hash->tabla = tabla_u64_crear();
+    if (!hash->tabla){
+        free(hash);
+        return NULL;
+    }
+    hash->destruir_dato = destruir_dato;
+    return hash;
+}
+
+bool hash_u64_guardar(hash_u64_t *hash, uint64_t clave, void *dato){
+    bool insertado;
+    void** lugar = tabla_u64_obtener_o_insertar(hash->tabla, clave, &insertado);
+    if (!lugar) return false;
+
+    if (!insertado && hash->destruir_dato) hash->destruir_dato(*lugar);
+    *lugar = dato;
+    return true;
+}
+
+void *hash_u64_borrar(hash_u64_t *hash, uint64_t clave){
+    void* dato;
+    return tabla_u64_borrar(hash->tabla, clave, &dato) ? dato : NULL;
+}
+
+void *hash_u64_obtener(const hash_u64_t *hash, uint64_t clave){
+    void** dato = tabla_u64_obtener(hash->tabla, clave);
+    return dato ? *dato : NULL;
+}
+
+bool hash_u64_pertenece(const hash_u64_t *hash, uint64_t clave){
+    return tabla_u64_pertenece(hash->tabla, clave);
+}
+
+size_t hash_u64_cantidad(const hash_u64_t *hash){
+	return tabla_u64_cantidad(hash->tabla);
+}
+
+void hash_u64_destruir(hash_u64_t *hash){
+    if (hash->destruir_dato){
+        tabla_u64_iter_t iter;
+        for (tabla_u64_iter_iniciar(&iter, hash->tabla); !tabla_u64_iter_al_final(&iter); tabla_u64_iter_avanzar(&iter)){
+            hash->destruir_dato(tabla_u64_iter_ver_actual(&iter)->valor);
+        }
+    }
+    tabla_u64_destruir(hash->tabla);
+    free(hash);
+}
+
+/* ******************************************************************
+ *                        ITERADOR HASH
+ * *****************************************************************/
+
+hash_u64_iter_t *hash_u64_iter_crear(const hash_u64_t *hash){
+
+    hash_u64_iter_t* iter = malloc(sizeof(hash_u64_iter_t));
+    if(!iter) return NULL;
+
+    tabla_u64_iter_iniciar(&iter->iter, hash->tabla);
+    return iter;
+}
+
+uint64_t hash_u64_iter_ver_actual(const hash_u64_iter_t *iter){
+	return tabla_u64_iter_ver_actual(&iter->iter)->clave;
+}
+
+void hash_u64_iter_destruir(hash_u64_iter_t* iter){
+	free(iter);
+}
+
+bool hash_u64_iter_avanzar(hash_u64_iter_t *iter){
+	return tabla_u64_iter_avanzar(&iter->iter);
+}
+
+bool hash_u64_iter_al_final(const hash_u64_iter_t *iter){
+    return tabla_u64_iter_al_final(&iter->iter);
+}
@@ -0,0 +1,165 @@
+/*
+ * hash_u64_pruebas.c
+ * Pruebas para el hash con claves enteras de 64 bits
+ */
+
+#include "hash_u64.h"
+#include "testing.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+/* ******************************************************************
+ *                        PRUEBAS UNITARIAS
+ * *****************************************************************/
+
+static void prueba_hash_u64_vacio()
+{
+    hash_u64_t* hash = hash_u64_crear(NULL);
+
+    print_test("Prueba hash u64 crear hash vacio", hash);
+    print_test("Prueba hash u64 la cantidad de elementos es 0", hash_u64_cantidad(hash) == 0);
+    print_test("Prueba hash u64 obtener clave 7, es NULL, no existe", !hash_u64_obtener(hash, 7));
+    print_test("Prueba hash u64 pertenece clave 0, es false, no existe", !hash_u64_pertenece(hash, 0));
+    print_test("Prueba hash u64 borrar clave 7, es NULL, no existe", !hash_u64_borrar(hash, 7));
+
+    hash_u64_iter_t* iter = hash_u64_iter_crear(hash);
+    print_test("Prueba hash u64 iter esta al final", hash_u64_iter_al_final(iter));
+    print_test("Prueba hash u64 iter avanzar es false", !hash_u64_iter_avanzar(iter));
+
+    hash_u64_iter_destruir(iter);
+    hash_u64_destruir(hash);
+}
+
+static void prueba_hash_u64_insertar_y_reemplazar()
+{
+    hash_u64_t* hash = hash_u64_crear(free);
+
+    int* valor1 = malloc(sizeof(int));
+    int* valor2 = malloc(sizeof(int));
+    int* valor3 = malloc(sizeof(int));
+    int* valor4 = malloc(sizeof(int));
+
+    /* La clave 0 y la clave máxima se guardan como cualquier otra */
+    print_test("Prueba hash u64 insertar clave 0", hash_u64_guardar(hash, 0, valor1));
+    print_test("Prueba hash u64 insertar clave UINT64_MAX", hash_u64_guardar(hash, UINT64_MAX, valor2));
+    print_test("Prueba hash u64 insertar clave 42", hash_u64_guardar(hash, 42, valor3));
+    print_test("Prueba hash u64 la cantidad de elementos es 3", hash_u64_cantidad(hash) == 3);
+    print_test("Prueba hash u64 obtener clave 0", hash_u64_obtener(hash, 0) == valor1);
+    print_test("Prueba hash u64 obtener clave UINT64_MAX", hash_u64_obtener(hash, UINT64_MAX) == valor2);
+
+    /* Reemplazar libera el dato anterior */
+    print_test("Prueba hash u64 reemplazar clave 42", hash_u64_guardar(hash, 42, valor4));
+    print_test("Prueba hash u64 la cantidad sigue en 3", hash_u64_cantidad(hash) == 3);
+    print_test("Prueba hash u64 obtener clave 42 reemplazada", hash_u64_obtener(hash, 42) == valor4);
+
+    size_t recorridos = 0;
+    hash_u64_iter_t* iter = hash_u64_iter_crear(hash);
+    bool ok = true;
+    while (!hash_u64_iter_al_final(iter)){
+        ok &= hash_u64_pertenece(hash, hash_u64_iter_ver_actual(iter));
+        recorridos++;
+        hash_u64_iter_avanzar(iter);
+    }
+    hash_u64_iter_destruir(iter);
+    print_test("Prueba hash u64 iterar recorre las 3 claves", ok && recorridos == 3);
+
+    print_test("Prueba hash u64 borrar clave 0", hash_u64_borrar(hash, 0) == valor1);
+    print_test("Prueba hash u64 clave 0 no pertenece", !hash_u64_pertenece(hash, 0));
+    free(valor1);
+
+    /* Destruir libera los que quedan */
+    hash_u64_destruir(hash);
+}
+
+static void prueba_hash_u64_colisiones(size_t largo)
+{
+    hash_u64_t* hash = hash_u64_crear(NULL);
+
+    /* Múltiplos de una potencia de 2 alta: mismo resto en cualquier tabla,
+     * así que prueban que la posición inicial usa los bits altos */
+    bool ok = true;
+    for (uint64_t i = 1; i <= largo; i++) ok &= hash_u64_guardar(hash, i << 40, NULL);
+    print_test("Prueba hash u64 guardar claves con bits bajos iguales", ok && hash_u64_cantidad(hash) == largo);
+
+    /* Borrar de a una y alternado deja las cadenas consistentes */
+    for (uint64_t i = 1; i <= largo; i += 2) ok &= !hash_u64_borrar(hash, i << 40) && !hash_u64_pertenece(hash, i << 40);
+    for (uint64_t i = 2; i <= largo; i += 2) ok &= hash_u64_pertenece(hash, i << 40);
+    print_test("Prueba hash u64 borrar la mitad", ok && hash_u64_cantidad(hash) == largo / 2);
+
+    for (uint64_t i = 2; i <= largo; i += 2) hash_u64_borrar(hash, i << 40);
+    print_test("Prueba hash u64 borrar el resto", hash_u64_cantidad(hash) == 0);
+
+    hash_u64_destruir(hash);
+}
+
+static void prueba_hash_u64_volumen(size_t largo, bool debug)
+{
+    hash_u64_t* hash = hash_u64_crear(NULL);
+
+    unsigned** valores = malloc(largo * sizeof(unsigned*));
+
+    /* Inserta 'largo' parejas en el hash */
+    bool ok = true;
+    for (unsigned i = 0; i < largo; i++) {
+        valores[i] = malloc(sizeof(int));
+        *valores[i] = i;
+        ok = hash_u64_guardar(hash, i, valores[i]);
+        if (!ok) break;
+    }
+
+    if (debug) print_test("Prueba hash u64 almacenar muchos elementos", ok);
+    if (debug) print_test("Prueba hash u64 la cantidad de elementos es correcta", hash_u64_cantidad(hash) == largo);
+
+    /* Verifica que devuelva los valores correctos */
+    for (size_t i = 0; i < largo; i++) {
+        ok = hash_u64_pertenece(hash, i);
+        if (!ok) break;
+        ok = hash_u64_obtener(hash, i) == valores[i];
+        if (!ok) break;
+    }
+
+    if (debug) print_test("Prueba hash u64 pertenece y obtener muchos elementos", ok);
+
+    /* Verifica que borre y devuelva los valores correctos */
+    for (size_t i = 0; i < largo; i++) {
+        ok = hash_u64_borrar(hash, i) == valores[i];
+        if (!ok) break;
+    }
+
+    if (debug) print_test("Prueba hash u64 borrar muchos elementos", ok);
+    if (debug) print_test("Prueba hash u64 la cantidad de elementos es 0", hash_u64_cantidad(hash) == 0);
+
+    /* Destruye el hash y crea uno nuevo que sí libera */
+    hash_u64_destruir(hash);
+    hash = hash_u64_crear(free);
+
+    for (size_t i = 0; i < largo; i++) {
+        ok = hash_u64_guardar(hash, i, valores[i]);
+        if (!ok) break;
+    }
+
+    free(valores);
+
+    /* Destruye el hash - debería liberar los enteros */
+    hash_u64_destruir(hash);
+}
+
+/* ******************************************************************
+ *                        FUNCIÓN PRINCIPAL
+ * *****************************************************************/
+
+
+void pruebas_hash_u64(void)
+{
+    prueba_hash_u64_vacio();
+    prueba_hash_u64_insertar_y_reemplazar();
+    prueba_hash_u64_colisiones(5000);
+    prueba_hash_u64_volumen(5000, true);
+}
+
+void pruebas_volumen_u64(size_t largo)
+{
+    prueba_hash_u64_volumen(largo, false);
+}
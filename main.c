@@ -1,6 +1,7 @@
 #include "testing.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 /* ******************************************************************
  *                        PROGRAMA PRINCIPAL
@@ -8,13 +9,47 @@
 
 void pruebas_hash_catedra(void);
 void pruebas_volumen_catedra(size_t);
+void pruebas_volumen_construir(size_t);
+void pruebas_volumen_snapshot(size_t);
+void pruebas_volumen_recorrer(size_t);
+void pruebas_volumen_compacto(size_t);
+void pruebas_volumen_paralelo(size_t);
+void pruebas_volumen_lote(size_t);
+void pruebas_hash_u64(void);
+void pruebas_volumen_u64(size_t);
+void pruebas_hash_generico(void);
+void pruebas_hash_concurrente(void);
+void pruebas_volumen_concurrente(size_t);
+void pruebas_hash_particionado(void);
+void pruebas_volumen_particionado(size_t);
+void pruebas_hash_congelado(void);
+void pruebas_volumen_congelado(size_t);
 
 int main(int argc, char *argv[])
 {
     if (argc > 1) {
         // Asumimos que nos están pidiendo pruebas de volumen.
+        // Con "u64" como segundo argumento, las corre con claves enteras, y
+        // con "concurrente" o "particionado" mide esos hashes de 1 a 64 hilos,
+        // con "construir" compara hash_guardar_lote con hash_construir y con
+        // "snapshot" lo compara con abrir un snapshot. Con "congelado" compara
+        // las búsquedas en un hash y en el mismo hash congelado, y con
+        // "recorrer" el iterador con el cursor en una tabla casi vacía. Con
+        // "compacto" mide el hash compacto contra el de siempre, y con
+        // "paralelo" recorre todo con uno y con varios hilos. Con "lote"
+        // compara hash_obtener con hash_obtener_lote.
         long largo = strtol(argv[1], NULL, 10);
-        pruebas_volumen_catedra((size_t) largo);
+        if (argc > 2 && strcmp(argv[2], "u64") == 0) pruebas_volumen_u64((size_t) largo);
+        else if (argc > 2 && strcmp(argv[2], "concurrente") == 0) pruebas_volumen_concurrente((size_t) largo);
+        else if (argc > 2 && strcmp(argv[2], "particionado") == 0) pruebas_volumen_particionado((size_t) largo);
+        else if (argc > 2 && strcmp(argv[2], "construir") == 0) pruebas_volumen_construir((size_t) largo);
+        else if (argc > 2 && strcmp(argv[2], "snapshot") == 0) pruebas_volumen_snapshot((size_t) largo);
+        else if (argc > 2 && strcmp(argv[2], "congelado") == 0) pruebas_volumen_congelado((size_t) largo);
+        else if (argc > 2 && strcmp(argv[2], "recorrer") == 0) pruebas_volumen_recorrer((size_t) largo);
+        else if (argc > 2 && strcmp(argv[2], "compacto") == 0) pruebas_volumen_compacto((size_t) largo);
+        else if (argc > 2 && strcmp(argv[2], "paralelo") == 0) pruebas_volumen_paralelo((size_t) largo);
+        else if (argc > 2 && strcmp(argv[2], "lote") == 0) pruebas_volumen_lote((size_t) largo);
+        else pruebas_volumen_catedra((size_t) largo);
 
         return failure_count() > 0;
     }
@@ -22,5 +57,20 @@ int main(int argc, char *argv[])
     printf("\n~~~ PRUEBAS CÁTEDRA ~~~\n");
     pruebas_hash_catedra();
 
+    printf("\n~~~ PRUEBAS HASH U64 ~~~\n");
+    pruebas_hash_u64();
+
+    printf("\n~~~ PRUEBAS HASH GENERICO ~~~\n");
+    pruebas_hash_generico();
+
+    printf("\n~~~ PRUEBAS HASH CONCURRENTE ~~~\n");
+    pruebas_hash_concurrente();
+
+    printf("\n~~~ PRUEBAS HASH PARTICIONADO ~~~\n");
+    pruebas_hash_particionado();
+
+    printf("\n~~~ PRUEBAS HASH CONGELADO ~~~\n");
+    pruebas_hash_congelado();
+
     return failure_count() > 0;
 }
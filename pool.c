@@ -0,0 +1,114 @@
+#define _POSIX_C_SOURCE 200809L
+#include "pool.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+/* Cada pool_ejecutar es una generación: los hilos esperan que cambie, toman
+ * tareas con un contador compartido hasta agotarlas y avisan al terminar.
+ * pool_ejecutar no vuelve hasta que todos avisaron, así ningún hilo puede
+ * quedar trabajando en una generación vieja. */
+struct pool {
+	pthread_t* hilos;
+	size_t cantidad;            // hilos propios, sin contar al que ejecuta
+	pthread_mutex_t mutex;
+	pthread_cond_t hay_trabajo;
+	pthread_cond_t terminaron;
+	size_t generacion;
+	size_t activos;
+	bool cerrar;
+	pool_tarea_t tarea;
+	void* extra;
+	size_t tareas;
+	size_t siguiente;
+};
+
+// Ejecuta tareas de la generación actual hasta que no quede ninguna.
+static void trabajar(pool_t *pool){
+    size_t indice;
+    while ((indice = __atomic_fetch_add(&pool->siguiente, 1, __ATOMIC_RELAXED)) < pool->tareas){
+        pool->tarea(pool->extra, indice);
+    }
+}
+
+static void *hilo(void *arg){
+    pool_t* pool = arg;
+    size_t vista = 0;
+
+    pthread_mutex_lock(&pool->mutex);
+    while (true){
+        while (pool->generacion == vista && !pool->cerrar) pthread_cond_wait(&pool->hay_trabajo, &pool->mutex);
+        if (pool->cerrar) break;
+        vista = pool->generacion;
+        pthread_mutex_unlock(&pool->mutex);
+
+        trabajar(pool);
+
+        pthread_mutex_lock(&pool->mutex);
+        if (--pool->activos == 0) pthread_cond_signal(&pool->terminaron);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+pool_t *pool_crear(size_t hilos){
+
+    pool_t* pool = calloc(1, sizeof(pool_t));
+    if (!pool) return NULL;
+
+    size_t propios = hilos > 1 ? hilos - 1 : 0;
+    pool->hilos = malloc(propios * sizeof(pthread_t) + 1);
+    if (!pool->hilos){
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->hay_trabajo, NULL);
+    pthread_cond_init(&pool->terminaron, NULL);
+
+    for (; pool->cantidad < propios; pool->cantidad++){
+        if (pthread_create(&pool->hilos[pool->cantidad], NULL, hilo, pool)){
+            pool_destruir(pool);
+            return NULL;
+        }
+    }
+    return pool;
+}
+
+size_t pool_hilos(const pool_t *pool){
+    return pool->cantidad + 1;
+}
+
+void pool_ejecutar(pool_t *pool, pool_tarea_t tarea, void *extra, size_t tareas){
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->tarea = tarea;
+    pool->extra = extra;
+    pool->tareas = tareas;
+    pool->siguiente = 0;
+    pool->activos = pool->cantidad;
+    pool->generacion++;
+    pthread_cond_broadcast(&pool->hay_trabajo);
+    pthread_mutex_unlock(&pool->mutex);
+
+    trabajar(pool);
+
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->activos > 0) pthread_cond_wait(&pool->terminaron, &pool->mutex);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+void pool_destruir(pool_t *pool){
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->cerrar = true;
+    pthread_cond_broadcast(&pool->hay_trabajo);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (size_t i = 0; i < pool->cantidad; i++) pthread_join(pool->hilos[i], NULL);
+    pthread_cond_destroy(&pool->terminaron);
+    pthread_cond_destroy(&pool->hay_trabajo);
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool->hilos);
+    free(pool);
+}
@@ -0,0 +1,31 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+
+/* Pool de hilos para repartir un trabajo en tareas independientes: el hilo
+ * que llama a pool_ejecutar trabaja junto con los del pool y vuelve cuando
+ * terminaron todas las tareas. */
+struct pool;
+typedef struct pool pool_t;
+
+// tipo de función de una tarea: recibe el puntero extra y el número de tarea
+typedef void (*pool_tarea_t)(void *extra, size_t indice);
+
+// Crea un pool para hilos hilos en total, contando al que llama a
+// pool_ejecutar. Devuelve NULL si no hay memoria o no se pudieron crear.
+pool_t *pool_crear(size_t hilos);
+
+// Devuelve la cantidad de hilos que trabajan en cada pool_ejecutar.
+size_t pool_hilos(const pool_t *pool);
+
+/* Ejecuta tarea(extra, i) para cada i de 0 a tareas - 1, repartidas entre
+ * los hilos, y espera a que terminen todas.
+ * Pre: ningún otro hilo está ejecutando en el mismo pool
+ */
+void pool_ejecutar(pool_t *pool, pool_tarea_t tarea, void *extra, size_t tareas);
+
+// Termina los hilos del pool y lo libera.
+void pool_destruir(pool_t *pool);
+
+#endif // POOL_H
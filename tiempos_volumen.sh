@@ -5,4 +5,26 @@ export TIME="Tardó: %Us - Consumió: %M KiB"
 for i in 12500 25000 50000 100000 200000 400000; do
     echo -n "$i elementos - "
     (command time $1 $i)
+    echo -n "$i elementos u64 - "
+    (command time $1 $i u64)
+    echo -n "$i elementos - "
+    $1 $i construir
+    echo -n "$i elementos - "
+    $1 $i snapshot
+    echo -n "$i elementos - "
+    $1 $i congelado
+    echo -n "$i elementos - "
+    $1 $i recorrer
+    echo -n "$i elementos - "
+    $1 $i compacto
+    echo -n "$i elementos - "
+    $1 $i paralelo
+    echo -n "$i elementos - "
+    $1 $i lote
 done
+
+echo "Hash concurrente con 100000 elementos:"
+$1 100000 concurrente
+
+echo "Hash particionado, insertando 400000 elementos:"
+$1 400000 particionado